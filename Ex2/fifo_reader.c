@@ -1,38 +1,59 @@
-#define _POSIX_SOURCE
-#include <errno.h> // errno
-#include <fcntl.h> // O_RDONLY, open
+#define _GNU_SOURCE
+#include <errno.h> // EAGAIN, EINTR, ENOENT, errno
+#include <fcntl.h> // O_RDONLY, O_NONBLOCK, F_SETPIPE_SZ, open, fcntl
 //#include <limits.h>
 #include <signal.h> // SIG_IGN, SIGINT, struct sigaction, sigaction, sigemptyset
 #include <stdio.h> // printf, fprintf, snprintf, stdout, stderr, fflush
 #include <stdlib.h> // EXIT_FAILURE, EXIT_SUCCESS
 #include <string.h> // strlen, strcpy, strcat, strerror, memset
+#include <sys/epoll.h> // EPOLLIN, EPOLL_CTL_ADD, struct epoll_event, epoll_create1, epoll_ctl, epoll_wait
 //#include <sys/stat.h>
-#include <sys/time.h> // gettimeofday, struct timeval
 #include <unistd.h> // sleep, read, close
 //#include <sys/mman.h>
+#include "perf_counters.h" // perf_region_t, perf_now, perf_elapsed_ms, perf_region_start, perf_region_stop, perf_region_print
+#include "simd_bytes.h" // SCAN_NO_TERMINATOR, scan_result_t, scan_bytes
 
 #define TMP_FOLDER "./tmp"
 #define FILE_NAME "osfifo"
 
-#define MAX_BUF 4096
+#define MAX_BUF (1024*1024) // Read up to 1MB per read(), a 4KB read costs a system call per page
+#define MAX_EVENTS 64
+#define PIPE_CAPACITY (1024*1024) // Requested pipe buffer size, fewer writer wakeups (best effort, see /proc/sys/fs/pipe-max-size)
 
 // Define printing strings
-#define BENCHMARK_MSG			"%d were read in %f milliseconds through FIFO\n"
-#define OPERANDS_SURPLUS_MSG		"Too many operands\nUsage: %s\n"
+#define BENCHMARK_MSG			"%lld were read in %f milliseconds through FIFO\n"
+#define STREAM_MSG			"%s: %lld were read in %f milliseconds (%f MB/s)\n"
 #define ERROR_EXIT_MSG			"Exiting...\n"
 #define ERROR_SIGACTION_INIT_MSG	"[Error] Failed to init signal handler (sigaction).\n"
 #define ERROR_SIGACTION_RESTORE_MSG	"[Error] Failed to restore signal handler (sigaction).\n"
+#define F_ERROR_INVALID_CHAR_MSG	"[Error] Got invalid char: %d\n"
 #define F_ERROR_CLOSE_PIPE_MSG		"[Error] Close pipe file '%s': %s\n"
+#define F_ERROR_EPOLL_MSG		"[Error] Error in %s: %s\n"
 #define F_ERROR_OPEN_PIPE_MSG		"[Error] Open pipe file '%s': %s\n"
 #define F_ERROR_READ_PIPE_MSG		"[Error] Read from pipe file '%s': %s\n"
 
+// Define data types
+typedef struct fifo_stream {
+	char *location; // The location of the pipe file in the file system
+	int fd; // The descriptor of the pipe file, -1 once the writer closed it
+	long long bytes; // Number of bytes read from this pipe
+	struct timespec t_first; // First data seen
+	struct timespec t_end; // EOF seen
+} fifo_stream_t;
+
 struct sigaction sigint_old_handler;
 
-int program_end(int error, int fd, char *location) {
+int program_end(int error, int epoll_fd, fifo_stream_t *streams, int streams_count) {
+	int i;
 	int res = 0;
-	if ((fd > 0)&&(close(fd) == -1)) { // Upon successful completion, 0 shall be returned; otherwise, -1 shall be returned and errno set to indicate the error.
-		fprintf(stderr,F_ERROR_CLOSE_PIPE_MSG,location,strerror(errno));
-		res = errno;
+	for (i = 0; i < streams_count; i++) {
+		if ((0 < streams[i].fd)&&(close(streams[i].fd) == -1)) { // Upon successful completion, 0 shall be returned; otherwise, -1 shall be returned and errno set to indicate the error.
+			fprintf(stderr,F_ERROR_CLOSE_PIPE_MSG,streams[i].location,strerror(errno));
+			res = errno;
+		}
+	}
+	if (0 < epoll_fd) {
+		close(epoll_fd);
 	}
 	if (sigaction(SIGINT,&sigint_old_handler,NULL) == -1) { // Returns 0 on success and -1 on error.
 		fprintf(stderr,ERROR_SIGACTION_RESTORE_MSG);
@@ -47,16 +68,80 @@ int program_end(int error, int fd, char *location) {
 	fflush(stderr);
 	return res;
 }
+int open_fifo(fifo_stream_t *stream) {
+	int open_delay_counter = 0;
+	do {
+		if ((stream->fd = open(stream->location,O_RDONLY | O_NONBLOCK)) == -1) { // Upon successful completion, ... return a non-negative integer .... Otherwise, -1 shall be returned and errno set to indicate the error.
+			if (errno == ENOENT) { // No such file or directory
+				sleep(1); // Wait for the writer to finish init (Only once), sleep 1 sec
+				open_delay_counter += 1;
+			} else { // Another error (not 'No such file or directory')
+				open_delay_counter = 2;
+			}
+		} else {
+			open_delay_counter = 3; // Exit while loop
+		}
+	} while (open_delay_counter < 2); // Wait MAX 2 sec
+	if (open_delay_counter == 2) {
+		fprintf(stderr,F_ERROR_OPEN_PIPE_MSG,stream->location,strerror(errno)); // No need to call fflush(stderr);
+		return errno;
+	}
+	fcntl(stream->fd,F_SETPIPE_SZ,PIPE_CAPACITY); // Only a hint, the default capacity is kept on failure
+	return 0;
+}
+int read_fifo(fifo_stream_t *stream, char *buf) {
+	// Read at most one buffer (MAX_BUF) per epoll wakeup, so a fast writer cannot starve the other pipes. The
+	// epoll set is level-triggered, what is left is reported again by the next epoll_wait(). Returns 1 on EOF,
+	// 0 if the pipe is still open, -1 on an invalid char or errno on a failed read().
+	ssize_t chars_read;
+	scan_result_t scan;
+	while (1) {
+		if ((chars_read = read(stream->fd, buf, MAX_BUF)) == -1) { // Upon successful completion, ... return a non-negative integer .... Otherwise, the functions shall return -1 and set errno to indicate the error.
+			if (errno == EAGAIN) { // Another reader of the pipe got there first, wait for the next event
+				return 0;
+			} else if (errno == EINTR) {
+				continue;
+			}
+			fprintf(stderr,F_ERROR_READ_PIPE_MSG,stream->location,strerror(errno)); // No need to call fflush(stderr);
+			return errno;
+		}
+		if (chars_read == 0) { // All writers closed the pipe
+			perf_now(&stream->t_end);
+			close(stream->fd); // Also removes it from the epoll set
+			stream->fd = -1;
+			return 1;
+		}
+		if (stream->bytes == 0) {
+			perf_now(&stream->t_first);
+		}
+		scan_bytes(buf,chars_read,'a',SCAN_NO_TERMINATOR,&scan); // Vectorized, every byte must be 'a'
+		if (scan.invalid) {
+			fprintf(stderr,F_ERROR_INVALID_CHAR_MSG,scan.stop_char);
+			return -1;
+		}
+		stream->bytes += chars_read;
+		return 0;
+	}
+}
 int main(int argc, char *argv[]) {
 	// General variable
-	char buf[MAX_BUF+1];
-	char pipe_location[strlen(TMP_FOLDER)+strlen(FILE_NAME)+2]; // The location of the pipe file in the file system
+	static char buf[MAX_BUF];
+	char default_location[strlen(TMP_FOLDER)+strlen(FILE_NAME)+2]; // The location of the pipe file in the file system
+	char *default_argv[1] = {default_location};
+	char **locations = argv+1; // The pipes to read, the default one if none was given
 	double elapsed_time;
-	int chars_read = 0;
-	int open_delay_counter;
-	int pipe_fd = -1; // The descriptor of the pipe file
-	int pipe_size = 0;
-	struct timeval t_start,t_end;
+	int epoll_fd = -1;
+	int events_count;
+	int i;
+	int res;
+	int streams_count = argc-1;
+	int streams_open;
+	long long total_size = 0;
+	struct epoll_event event;
+	struct epoll_event events[MAX_EVENTS];
+	perf_region_t region;
+	struct timespec *t_start = NULL;
+	struct timespec *t_end = NULL;
 	struct sigaction sigint_new_handler;
 	// Create signal handlers
 	//memset(&sigint_new_handler, 0, sizeof(sigint_new_handler)); // We were not allowed to use memset,
@@ -69,46 +154,77 @@ int main(int argc, char *argv[]) {
 		return (EXIT_FAILURE);
 	}
 	// Check correct call structure
-	if (argc != 1) {
-		printf(OPERANDS_SURPLUS_MSG,argv[0]);
-		fflush(stdout);
-		return (program_end(-1,pipe_fd,pipe_location)); // Close pipe file & Restore signal handler.
+	snprintf(default_location,sizeof(default_location),"%s/%s",TMP_FOLDER,FILE_NAME); // Set 'default_location' to be the path to the communication file
+	if (streams_count == 0) {
+		locations = default_argv;
+		streams_count = 1;
 	}
-	// 1. Open /tmp/osfifo for reading
-	snprintf(pipe_location,sizeof(pipe_location),"%s/%s",TMP_FOLDER,FILE_NAME); // Set 'pipe_location' to be the path to the communication file
-	open_delay_counter = 0;
-	do {
-		if ((pipe_fd = open(pipe_location,O_RDONLY)) == -1) { // Upon successful completion, ... return a non-negative integer .... Otherwise, -1 shall be returned and errno set to indicate the error.
-			if (errno == 2) { // No such file or directory
-				sleep(1); // Wait for the writer to finish init (Only once), sleep 1 sec
-				open_delay_counter += 1;
-			} else { // Another error (not 'No such file or directory')
-				open_delay_counter = 2;
-			}
-		} else {
-			open_delay_counter = 3; // Exit while loop
+	fifo_stream_t streams[streams_count];
+	for (i = 0; i < streams_count; i++) {
+		streams[i].location = locations[i];
+		streams[i].fd = -1;
+		streams[i].bytes = 0;
+	}
+	if ((epoll_fd = epoll_create1(0)) == -1) { // On success, these system calls return a file descriptor. On error, -1 is returned, and errno is set to indicate the error.
+		fprintf(stderr,F_ERROR_EPOLL_MSG,"epoll_create1()",strerror(errno));
+		return (program_end(errno,epoll_fd,streams,streams_count)); // Close pipe files & Restore signal handler.
+	}
+	// 1. Open /tmp/osfifo (or every FIFO given) for reading
+	for (i = 0; i < streams_count; i++) {
+		if ((res = open_fifo(&streams[i])) != 0) {
+			return (program_end(res,epoll_fd,streams,streams_count)); // Close pipe files & Restore signal handler.
+		}
+		event.events = EPOLLIN; // EPOLLHUP is always reported
+		event.data.ptr = &streams[i];
+		if (epoll_ctl(epoll_fd,EPOLL_CTL_ADD,streams[i].fd,&event) == -1) { // When successful, epoll_ctl() returns zero. When an error occurs, epoll_ctl() returns -1 and errno is set to indicate the error.
+			fprintf(stderr,F_ERROR_EPOLL_MSG,"epoll_ctl()",strerror(errno));
+			return (program_end(errno,epoll_fd,streams,streams_count)); // Close pipe files & Restore signal handler.
 		}
-	} while (open_delay_counter < 2); // Wait MAX 2 sec
-	if (open_delay_counter == 2) { // No such file or directory
-		fprintf(stderr,F_ERROR_OPEN_PIPE_MSG,pipe_location,strerror(errno)); // No need to call fflush(stderr);
-		return (program_end(errno,pipe_fd,pipe_location)); // Close pipe file & Restore signal handler.
 	}
-	// 2. Start the time measurement
-	gettimeofday(&t_start,NULL);
-	// 3. Read data and count the number of 'a' bytes read
-	do {
-		if ((chars_read = read(pipe_fd, buf, MAX_BUF)) == -1) { // Upon successful completion, ... return a non-negative integer .... Otherwise, the functions shall return -1 and set errno to indicate the error.
-			fprintf(stderr,F_ERROR_READ_PIPE_MSG,pipe_location,strerror(errno)); // No need to call fflush(stderr);
-			return (program_end(errno,pipe_fd,pipe_location)); // Close pipe file & Restore signal handler.
+	// 2. Start the time measurement (per pipe, when its first data arrives)
+	perf_region_start(&region);
+	// 3. Read data and count the number of 'a' bytes read, until every writer closed its pipe
+	streams_open = streams_count;
+	while (0 < streams_open) {
+		if ((events_count = epoll_wait(epoll_fd,events,MAX_EVENTS,-1)) == -1) { // On success, returns the number of file descriptors ready. On error, returns -1 and errno is set to indicate the error.
+			if (errno == EINTR) {
+				continue;
+			}
+			fprintf(stderr,F_ERROR_EPOLL_MSG,"epoll_wait()",strerror(errno));
+			return (program_end(errno,epoll_fd,streams,streams_count)); // Close pipe files & Restore signal handler.
+		}
+		for (i = 0; i < events_count; i++) {
+			if ((res = read_fifo(events[i].data.ptr,buf)) == 1) { // EOF
+				streams_open -= 1;
+			} else if (res != 0) {
+				return (program_end(res,epoll_fd,streams,streams_count)); // Close pipe files & Restore signal handler.
+			}
 		}
-		pipe_size += chars_read;
-	} while (chars_read == MAX_BUF);
-	// 4. Finish the time measurement
-	gettimeofday(&t_end,NULL);
-	elapsed_time = ((t_end.tv_sec-t_start.tv_sec)*1000.0) + ((t_end.tv_usec-t_start.tv_usec)/1000.0);
+	}
+	// 4. Finish the time measurement (per pipe, when its writer closed it)
+	perf_region_stop(&region);
 	// 5. Print the measurement result along with the number of bytes read
-	printf(BENCHMARK_MSG,pipe_size,elapsed_time);
+	if (1 < streams_count) {
+		for (i = 0; i < streams_count; i++) {
+			elapsed_time = (0 < streams[i].bytes) ? perf_elapsed_ms(&streams[i].t_first,&streams[i].t_end) : 0;
+			printf(STREAM_MSG,streams[i].location,streams[i].bytes,elapsed_time,(0 < elapsed_time) ? (streams[i].bytes/1000.0)/elapsed_time : 0);
+		}
+	}
+	for (i = 0; i < streams_count; i++) { // The total runs from the first data on any pipe to the last EOF
+		if (0 < streams[i].bytes) {
+			total_size += streams[i].bytes;
+			if ((t_start == NULL)||(perf_elapsed_ms(&streams[i].t_first,t_start) > 0)) {
+				t_start = &streams[i].t_first;
+			}
+			if ((t_end == NULL)||(perf_elapsed_ms(t_end,&streams[i].t_end) > 0)) {
+				t_end = &streams[i].t_end;
+			}
+		}
+	}
+	elapsed_time = (t_start != NULL) ? perf_elapsed_ms(t_start,t_end) : 0;
+	printf(BENCHMARK_MSG,total_size,elapsed_time);
+	perf_region_print(stdout,&region);
 	fflush(stdout);
 	// 6. Cleanup. Exit gracefully
-	return (program_end(0,pipe_fd,pipe_location)); // Close pipe file & Restore signal handler.
+	return (program_end(0,epoll_fd,streams,streams_count)); // Close pipe files & Restore signal handler.
 }
@@ -1,4 +1,4 @@
-#define _POSIX_SOURCE
+#define _GNU_SOURCE
 #include <errno.h> // errno
 #include <fcntl.h> // O_WRONLY, open
 #include <limits.h> // LONG_MAX, LONG_MIN
@@ -7,9 +7,9 @@
 #include <stdlib.h> // EXIT_FAILURE, EXIT_SUCCESS, strtol, exit
 #include <string.h> // strlen, strcpy, strcat, strerror, memset
 #include <sys/stat.h> // mkfifo, chmod
-#include <sys/time.h> // gettimeofday, struct timeval
 #include <unistd.h> // EACCES, ENOENT, R_OK, W_OK, write, close, unlink, access
 //#include <sys/mman.h>
+#include "perf_counters.h" // perf_region_t, perf_region_start, perf_region_stop, perf_region_ms, perf_region_print
 
 #define TMP_FOLDER "./tmp"
 #define FILE_NAME "osfifo"
@@ -17,7 +17,7 @@
 #define MAX_BUF 4096
 
 // Define printing strings
-#define BENCHMARK_MSG			"%d were written in %f milliseconds through FIFO\n"
+#define BENCHMARK_MSG			"%ld were written in %f milliseconds through FIFO\n"
 #define NUM_LESS_THEN_ONE_MSG		"The input value '%d' is too small\n"
 #define OPERANDS_MISSING_MSG		"Missing operands\nUsage: %s <NUM>\n"
 #define OPERANDS_SURPLUS_MSG		"Too many operands\nUsage: %s <NUM>\n"
@@ -79,7 +79,7 @@ int main(int argc, char *argv[]) {
 	int remaining_data;
 	int sig_creation_count;
 	long pipe_size;
-	struct timeval t_start,t_end;
+	perf_region_t region;
 	struct sigaction sigint_new_handler;
 	struct sigaction sigpipe_new_handler;
 	// Create signal handlers
@@ -146,7 +146,7 @@ int main(int argc, char *argv[]) {
 		return (program_end(errno,pipe_fd,pipe_location)); // Close and unlink pipe file & Restore signal handler.
 	}
 	// 3. Start the time measurement
-	gettimeofday(&t_start,NULL);
+	perf_region_start(&region);
 	// 4. Write NUM 'a' bytes to this named pipe file
 	remaining_data = pipe_size;
 	strcpy(buf, "a");
@@ -175,10 +175,11 @@ int main(int argc, char *argv[]) {
 		}
 	}
 	// 5. Finish the time measurement
-	gettimeofday(&t_end,NULL);
-	elapsed_time = ((t_end.tv_sec-t_start.tv_sec)*1000.0) + ((t_end.tv_usec-t_start.tv_usec)/1000.0);
+	perf_region_stop(&region);
+	elapsed_time = perf_region_ms(&region);
 	// 6. Print the measurement result along with the number of bytes written
 	printf(BENCHMARK_MSG,pipe_size,elapsed_time);
+	perf_region_print(stdout,&region);
 	fflush(stdout);
 	// 7. Remove the file from the disk (man 2 unlink)
 	// 8. Cleanup. Exit gracefully
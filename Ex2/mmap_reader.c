@@ -1,41 +1,52 @@
-#define _POSIX_SOURCE
+#define _GNU_SOURCE
+#define _FILE_OFFSET_BITS 64 // 64-bit off_t for mmap() offsets and st_size, also on 32-bit hosts
 #include <errno.h> // errno
 #include <fcntl.h> // O_RDONLY, open
-//#include <limits.h>
-#include <signal.h> // SIG_IGN, SIGUSR1, SIGTERM, struct sigaction, sigaction, sigemptyset
+#include <limits.h> // LLONG_MAX
+#include <pthread.h> // pthread_create, pthread_join (link with -pthread)
+#include <signal.h> // SIG_IGN, SIG_BLOCK, SIG_SETMASK, SIGINT, SIGUSR1, SIGTERM, struct sigaction, sigaction, sigemptyset, sigaddset, sigprocmask
 #include <stdio.h> // printf, fprintf, snprintf, stdout, stderr, fflush, perror
-#include <stdlib.h> // EXIT_FAILURE, EXIT_SUCCESS
-#include <string.h> // strlen, strerror, memset
+#include <stdlib.h> // EXIT_FAILURE, EXIT_SUCCESS, strtol
+#include <string.h> // strlen, strcmp, strncmp, strerror, memset
+#include <sys/signalfd.h> // SFD_CLOEXEC, struct signalfd_siginfo, signalfd
 #include <sys/stat.h> // stat
-#include <sys/time.h> // gettimeofday, struct timeval
-#include <unistd.h> // sleep, close, unlink
-#include <sys/mman.h> // PROT_READ, MAP_SHARED, MAP_FAILED, mmap, munmap
+#include <unistd.h> // read, close, unlink
+#include <sys/mman.h> // PROT_READ, MAP_FAILED, MADV_DONTNEED, madvise, munmap
+#include "mmap_window.h" // map_options_t, map_stats_t, map_options_init, map_options_parse, map_options_finish, map_window
+#include "perf_counters.h" // perf_region_t, perf_thread_faults, perf_region_start, perf_region_stop, perf_region_ms, perf_region_print
+#include "simd_bytes.h" // scan_kernel_t, scan_result_t, scan_bytes_select
 
 #define TMP_FOLDER "./tmp"
 #define FILE_NAME "mmapped.bin"
 
+#define THREADS_MAX 256 // Upper limit for '-j'
+
 // Define printing strings
-#define BENCHMARK_MSG			"%d were read in %f milliseconds through MMAP\n"
-#define OPERANDS_SURPLUS_MSG		"Too many operands\nUsage: %s\n"
+#define BENCHMARK_MSG			"%lld were read in %f milliseconds through MMAP\n"
+#define OPERANDS_INVALID_MSG		"Invalid option '%s'\nUsage: %s [--loop] [-j THREADS] [--window=BYTES] [--populate] [--thp] [--hugetlb=DIR]\n"
 #define ERROR_EXIT_MSG			"Exiting...\n"
 #define ERROR_SIGACTION_INIT_MSG	"[Error] Failed to init signal handler (sigaction).\n"
 #define ERROR_SIGACTION_RESTORE_MSG	"[Error] Failed to restore signal handler (sigaction).\n"
 #define F_ERROR_CLOSE_MMAP_MSG		"[Error] Close mmap file '%s': %s\n"
 #define F_ERROR_INVALID_CHAR_MSG	"[Error] Got invalid char: %d\n"
 #define F_ERROR_OPEN_MMAP_MSG		"[Error] Open mmap file '%s': %s\n"
+#define F_ERROR_READ_SIGNALFD_MSG	"[Error] Read from signalfd: %s\n"
+#define F_ERROR_SIGNALFD_MSG		"[Error] Create signalfd: %s\n"
+#define F_ERROR_PTHREAD_MSG		"[Error] Error in %s: %s\n"
 #define F_ERROR_STAT_MSG		"[Error] Getting information for file '%s': %s\n"
 #define F_ERROR_UNLINK_FAILED_MSG	"[Error] Failed to delete file '%s': %s\n"
 #define P_ERROR_MAPPING_MSG		"[Error] Error mmapping the file"
 #define P_ERROR_UNMMAPPING_MSG		"[Error] Error un-mmapping the file"
 
-int exit_with_error = 0; // Init to 'EXIT_SUCCESS'
-int finish_loop_and_exit = 1; // Init to stay in the infinity loop
+int threads_count = 1; // '-j', number of threads that scan the mapping
+long long scan_stop_min; // Lowest offset of a NULL or invalid char found so far by any thread, LLONG_MAX if none
+map_options_t map_options; // '--window=', '--populate', '--thp' and '--hugetlb='
+sigset_t sigmask_old; // The signal mask before SIGUSR1 was blocked for the signalfd
 struct sigaction sigterm_old_handler;
-struct sigaction sigusr1_old_handler;
 
-int program_end(int error, int fd, char *location, int mmap_size, char *arr) {
+int handoff_end(int error, int fd, char *location, size_t map_len, char *arr) {
 	int res = 0;
-	if ((0 < mmap_size)&&(munmap(arr,mmap_size) == -1)) { // returns 0, on failure -1, and errno is set (probably to EINVAL)
+	if ((0 < map_len)&&(munmap(arr,map_len) == -1)) { // returns 0, on failure -1, and errno is set (probably to EINVAL)
 		perror(P_ERROR_UNMMAPPING_MSG);
 		res = errno;
 	}
@@ -47,7 +58,17 @@ int program_end(int error, int fd, char *location, int mmap_size, char *arr) {
 		fprintf(stderr,F_ERROR_UNLINK_FAILED_MSG,location,strerror(errno));
 		res = errno;
 	}
-	if ((sigaction(SIGTERM,&sigterm_old_handler,NULL) == -1) || (sigaction(SIGUSR1,&sigusr1_old_handler,NULL) == -1)) { // Returns 0 on success and -1 on error.
+	if (error != 0) { // If multiple error occurred, Return the error that called 'handoff_end' function.
+		res = error;
+	}
+	return res;
+}
+int program_end(int error, int signal_fd) {
+	int res = 0;
+	if (0 < signal_fd) {
+		close(signal_fd);
+	}
+	if ((sigaction(SIGTERM,&sigterm_old_handler,NULL) == -1) || (sigprocmask(SIG_SETMASK,&sigmask_old,NULL) == -1)) { // Returns 0 on success and -1 on error.
 		fprintf(stderr,ERROR_SIGACTION_RESTORE_MSG);
 		res = -1;
 	}
@@ -58,99 +79,250 @@ int program_end(int error, int fd, char *location, int mmap_size, char *arr) {
 		}
 	}
 	fflush(stderr);
-	finish_loop_and_exit = 0; // Exit the infinity loop
-	exit_with_error = res; // Set the exit code
 	return res;
 }
-void sigusr1_handler(int signum) {
-	// General variable
+// Define data types
+typedef struct scan_job {
+	int fd; // The descriptor of the mmap file
+	scan_kernel_t scan; // The scan_bytes() kernel, selected once before the threads start
+	long long start; // First offset of the range scanned by this thread
+	long long end; // First offset after the range
+	long long count; // Number of 'a' bytes before 'stop' (or in the whole range)
+	long long stop; // File offset of the first char that is not 'a' in the range, -1 if none
+	int stop_char; // The char at 'stop'
+	int invalid; // 1 if the char at 'stop' is not NULL ('\0')
+	int error; // errno of a failed mmap() or munmap(), 0 if none
+	const char *error_msg; // perror() prefix that goes with 'error'
+	map_stats_t stats; // Mapping time and page faults of this thread
+} scan_job_t;
+
+void *thrd_scan_range(void *argStruct) {
+	// Scan the range [start,end) of the file window by window. A thread stops early when another thread
+	// already found a NULL or invalid char at a lower offset, since nothing after that is counted.
 	char *arr;
-	char mmap_location[strlen(TMP_FOLDER)+strlen(FILE_NAME)+2]; // The location of the mmap file in the file system
+	long faults;
+	long long offset;
+	long long stop_min;
+	size_t map_len;
+	scan_result_t scan;
+	scan_job_t *job = argStruct;
+	job->count = 0;
+	job->stop = -1;
+	job->error = 0;
+	job->stats.map_time = 0;
+	job->stats.map_faults = 0;
+	job->stats.touch_faults = 0;
+	for (offset = job->start; offset < job->end; offset += map_len) {
+		if (__atomic_load_n(&scan_stop_min,__ATOMIC_RELAXED) < offset) { // A thread before us found the end
+			break;
+		}
+		map_len = ((job->end-offset) < map_options.window_size) ? (size_t)(job->end-offset) : (size_t)map_options.window_size;
+		if ((arr = map_window(job->fd,map_len,offset,PROT_READ,&map_options,&job->stats)) == MAP_FAILED) {
+			job->error = errno;
+			job->error_msg = P_ERROR_MAPPING_MSG;
+			break;
+		}
+		faults = perf_thread_faults();
+		job->scan(arr,map_len,'a','\0',&scan); // Vectorized, stops at the first byte that is not 'a'
+		job->stats.touch_faults += perf_thread_faults()-faults;
+		job->count += scan.count;
+		madvise(arr,map_len,MADV_DONTNEED); // Only a hint, drop the scanned pages from our RSS right away
+		if (munmap(arr,map_len) == -1) { // returns 0, on failure -1, and errno is set (probably to EINVAL)
+			job->error = errno;
+			job->error_msg = P_ERROR_UNMMAPPING_MSG;
+			break;
+		}
+		if (0 <= scan.stop) {
+			job->stop = offset+scan.stop;
+			job->stop_char = scan.stop_char;
+			job->invalid = scan.invalid;
+			stop_min = __atomic_load_n(&scan_stop_min,__ATOMIC_RELAXED);
+			while ((job->stop < stop_min)&&(!__atomic_compare_exchange_n(&scan_stop_min,&stop_min,job->stop,1,__ATOMIC_RELAXED,__ATOMIC_RELAXED))) {
+				; // 'stop_min' was reloaded by the failed exchange
+			}
+			break;
+		}
+	}
+	return NULL;
+}
+int process_handoff(void) {
+	// General variable
+	const char *folder = (map_options.folder != NULL) ? map_options.folder : TMP_FOLDER;
+	char mmap_location[strlen(folder)+strlen(FILE_NAME)+2]; // The location of the mmap file in the file system
 	double elapsed_time;
 	int i;
-	int char_count = 0;
+	int rc; // Variable for pthread_create & pthread_join
 	int mmap_fd = -1; // The descriptor of the mmap file
-	int mmap_size;
-	struct timeval t_start,t_end;
+	int threads_started = 0;
+	long long char_count = 0;
+	long long chunk_size;
+	long long mmap_size;
+	map_stats_t stats = {0,0,0};
+	pthread_t threads[THREADS_MAX];
+	scan_job_t jobs[THREADS_MAX];
+	scan_kernel_t scan; // Picked here, not by the first worker that scans
+	perf_region_t region;
 	struct stat mmap_stat;
-	// Upon receiving a SIGUSR1 signal:
-	if (signum == SIGUSR1) { // just to be one the safe side
-		snprintf(mmap_location,sizeof(mmap_location),"%s/%s",TMP_FOLDER,FILE_NAME); // Set 'mmap_location' to be the path to the communication file
-		// 1. Open the file /tmp/mmapped.bin
-		if ((mmap_fd = open(mmap_location,O_RDONLY)) == -1) { // Upon successful completion, ... return a non-negative integer .... Otherwise, -1 shall be returned and errno set to indicate the error.
-			fprintf(stderr,F_ERROR_OPEN_MMAP_MSG,mmap_location,strerror(errno)); // No need to call fflush(stderr);
-			program_end(errno,mmap_fd,mmap_location,0,""); // Unmap, close and unlink mmap file & Restore signal handler.
-			return; // EXIT_FAILURE
+	snprintf(mmap_location,sizeof(mmap_location),"%s/%s",folder,FILE_NAME); // Set 'mmap_location' to be the path to the communication file
+	// 1. Open the file /tmp/mmapped.bin
+	if ((mmap_fd = open(mmap_location,O_RDONLY)) == -1) { // Upon successful completion, ... return a non-negative integer .... Otherwise, -1 shall be returned and errno set to indicate the error.
+		fprintf(stderr,F_ERROR_OPEN_MMAP_MSG,mmap_location,strerror(errno)); // No need to call fflush(stderr);
+		return handoff_end(errno,mmap_fd,mmap_location,0,""); // Unmap, close and unlink mmap file.
+	}
+	// 2. Determine the file size (man 2 lseek, man 2 stat)
+	if (stat(mmap_location, &mmap_stat) == -1) { // On success, zero is returned. On error, -1 is returned, and errno is set appropriately.
+		fprintf(stderr,F_ERROR_STAT_MSG,mmap_location,strerror(errno));
+		return handoff_end(errno,mmap_fd,mmap_location,0,""); // Unmap, close and unlink mmap file.
+	}
+	mmap_size = mmap_stat.st_size;
+	// 3. Start the time measurement
+	perf_region_start(&region);
+	// 4. Create a memory map for the file, one window at a time
+	// 5. Count the number of 'a' bytes in the array until the first NULL ('\0')
+	// With '-j' the file is split into page aligned ranges that are scanned concurrently. The partial counts
+	// are merged in file order up to the range holding the first NULL, which is the minimum over all threads.
+	chunk_size = (mmap_size+threads_count-1)/threads_count;
+	chunk_size = map_options_round(&map_options,chunk_size); // mmap() offsets must be page aligned
+	scan_stop_min = LLONG_MAX;
+	scan = scan_bytes_select();
+	for (i = 0; i < threads_count; i++) {
+		jobs[i].fd = mmap_fd;
+		jobs[i].scan = scan;
+		jobs[i].start = (i*chunk_size < mmap_size) ? i*chunk_size : mmap_size;
+		jobs[i].end = (jobs[i].start+chunk_size < mmap_size) ? jobs[i].start+chunk_size : mmap_size;
+	}
+	for (i = 1; i < threads_count; i++) { // The calling thread scans the first range itself
+		if ((rc = pthread_create(&threads[i],NULL,thrd_scan_range,&jobs[i])) != 0) { // On success, pthread_create() returns 0; on error, it returns an error number, and the contents of *thread are undefined.
+			fprintf(stderr,F_ERROR_PTHREAD_MSG,"pthread_create()",strerror(rc));
+			break;
 		}
-		// 2. Determine the file size (man 2 lseek, man 2 stat)
-		if (stat(mmap_location, &mmap_stat) == -1) { // On success, zero is returned. On error, -1 is returned, and errno is set appropriately.
-			fprintf(stderr,F_ERROR_STAT_MSG,mmap_location,strerror(errno));
-			program_end(errno,mmap_fd,mmap_location,0,""); // Unmap, close and unlink mmap file & Restore signal handler.
-			return; // EXIT_FAILURE
+		threads_started += 1;
+	}
+	if (threads_started == threads_count-1) {
+		thrd_scan_range(&jobs[0]);
+	} else {
+		__atomic_store_n(&scan_stop_min,-1,__ATOMIC_RELAXED); // Tell the started threads to stop
+		jobs[0].error = rc;
+		jobs[0].error_msg = NULL;
+	}
+	for (i = 1; i <= threads_started; i++) {
+		if ((rc = pthread_join(threads[i],NULL)) != 0) { // On success, pthread_join() returns 0; on error, it returns an error number.
+			fprintf(stderr,F_ERROR_PTHREAD_MSG,"pthread_join()",strerror(rc));
 		}
-		mmap_size = mmap_stat.st_size;
-		// 3. Start the time measurement
-		gettimeofday(&t_start,NULL);
-		// 4. Create a memory map for the file
-		if ((arr = (char*) mmap(NULL,mmap_size,PROT_READ,MAP_SHARED,mmap_fd,0)) == MAP_FAILED) { // On success, mmap() returns a pointer to the mapped area. On error, the value MAP_FAILED ... is returned, and errno is set appropriately.
-			perror(P_ERROR_MAPPING_MSG);
-			program_end(errno,mmap_fd,mmap_location,mmap_size,arr); // Unmap, close and unlink mmap file & Restore signal handler.
-			return; // EXIT_FAILURE
+	}
+	for (i = 0; i < threads_count; i++) {
+		if (jobs[i].error != 0) {
+			if (jobs[i].error_msg != NULL) {
+				errno = jobs[i].error;
+				perror(jobs[i].error_msg);
+			}
+			return handoff_end(jobs[i].error,mmap_fd,mmap_location,0,""); // Close and unlink mmap file.
 		}
-		// 5. Count the number of 'a' bytes in the array until the first NULL ('\0')
-		for (i = 0; i < mmap_size; i++) {
-			if (arr[i] == 'a') {
-				char_count +=1;
-			} else if (arr[i] == '\0') {
-				char_count +=1;
-				break;
-			} else {
-				fprintf(stderr,F_ERROR_INVALID_CHAR_MSG,arr[i]);
-				program_end(-1,mmap_fd,mmap_location,mmap_size,arr); // Unmap, close and unlink mmap file & Restore signal handler.
-				return; // EXIT_FAILURE
+		char_count += jobs[i].count;
+		if (0 <= jobs[i].stop) {
+			if (jobs[i].invalid) {
+				fprintf(stderr,F_ERROR_INVALID_CHAR_MSG,jobs[i].stop_char);
+				return handoff_end(-1,mmap_fd,mmap_location,0,""); // Close and unlink mmap file.
 			}
+			char_count += 1; // Found the NULL ('\0')
+			break;
 		}
-		// 6. Finish the time measurement
-		gettimeofday(&t_end,NULL);
-		elapsed_time = ((t_end.tv_sec-t_start.tv_sec)*1000.0) + ((t_end.tv_usec-t_start.tv_usec)/1000.0);
-		// 7. Print the measurement result along with the number of bytes counted
-		printf(BENCHMARK_MSG,char_count,elapsed_time);
-		fflush(stdout);
-		// 8. Remove the file from the disk (man 2 unlink)
-		// 9. Cleanup. Exit gracefully (man 3 exit)
-		program_end(0,mmap_fd,mmap_location,mmap_size,arr); // Unmap, close and unlink mmap file & Restore signal handler.
-		return; // EXIT_SUCCESS
 	}
+	// 6. Finish the time measurement
+	perf_region_stop(&region);
+	elapsed_time = perf_region_ms(&region);
+	for (i = 0; i < threads_count; i++) { // Every range was scanned (or skipped early), so every job has its stats
+		stats.map_time += jobs[i].stats.map_time;
+		stats.map_faults += jobs[i].stats.map_faults;
+		stats.touch_faults += jobs[i].stats.touch_faults;
+	}
+	// 7. Print the measurement result along with the number of bytes counted
+	printf(BENCHMARK_MSG,char_count,elapsed_time);
+	perf_region_print(stdout,&region);
+	printf(MAP_STATS_MSG,stats.map_time,stats.map_faults,stats.touch_faults);
+	fflush(stdout);
+	// 8. Remove the file from the disk (man 2 unlink)
+	return handoff_end(0,mmap_fd,mmap_location,0,""); // Close and unlink mmap file.
 }
 int main(int argc, char *argv[]) {
 	// General variable
-	int sig_creation_count;
+	char *endptr; // strtoll var
+	char *invalid_option = NULL;
+	int i;
+	int keep_serving = 0; // '--loop', serve handoffs until SIGINT instead of exiting after the first one
+	int res = 0;
+	int signal_fd = -1;
+	sigset_t sigmask_events;
 	struct sigaction sigterm_new_handler;
-	struct sigaction sigusr1_new_handler;
+	struct signalfd_siginfo event;
+	// Parse the options before the signal mask is set, so '--loop' can add SIGINT to it
+	map_options_init(&map_options);
+	for (i = 1; i < argc; i++) {
+		if (strcmp(argv[i],"--loop") == 0) {
+			keep_serving = 1;
+		} else if ((res = map_options_parse(&map_options,argv[i])) != 0) {
+			if (res == -1) {
+				invalid_option = argv[i];
+			}
+		} else if (strncmp(argv[i],"-j",2) == 0) { // '-j N' or '-jN'
+			if ((argv[i][2] == '\0')&&(i+1 < argc)) {
+				i += 1;
+				threads_count = strtol(argv[i], &endptr, 10);
+			} else {
+				threads_count = strtol(argv[i]+2, &endptr, 10);
+			}
+			if ((*endptr != '\0')||(threads_count < 1)||(THREADS_MAX < threads_count)) {
+				invalid_option = argv[i];
+			}
+		} else {
+			invalid_option = argv[i];
+		}
+	}
 	// 1. Register a signal handler for SIGUSR1 (man 2 sigaction)
+	// SIGUSR1 is blocked and consumed through a signalfd, so the work runs in main and not in a signal handler
 	//memset(&sigterm_new_handler, 0, sizeof(sigterm_new_handler)); // We were not allowed to use memset,
-	//memset(&sigusr1_new_handler, 0, sizeof(sigusr1_new_handler)); // We were not allowed to use memset,
 	sigemptyset(&sigterm_new_handler.sa_mask);
-	sigemptyset(&sigusr1_new_handler.sa_mask);
 	sigterm_new_handler.sa_handler = SIG_IGN;
-	sigusr1_new_handler.sa_handler = sigusr1_handler;
-	sig_creation_count =  sigaction(SIGTERM,&sigterm_new_handler,&sigterm_old_handler); // Returns 0 on success and -1 on error.
-	sig_creation_count += sigaction(SIGUSR1,&sigusr1_new_handler,&sigusr1_old_handler); // Returns 0 on success and -1 on error.
-	if (sig_creation_count < 0) { // if (sig_creation_count == -1) or (sig_creation_count == -2)
+	sigemptyset(&sigmask_events);
+	sigaddset(&sigmask_events,SIGUSR1);
+	if (keep_serving) {
+		sigaddset(&sigmask_events,SIGINT);
+	}
+	if ((sigaction(SIGTERM,&sigterm_new_handler,&sigterm_old_handler) == -1) || (sigprocmask(SIG_BLOCK,&sigmask_events,&sigmask_old) == -1)) { // Returns 0 on success and -1 on error.
 		fprintf(stderr,ERROR_SIGACTION_INIT_MSG);
 		fprintf(stderr,ERROR_EXIT_MSG);
 		fflush(stderr);
 		return (EXIT_FAILURE);
 	}
 	// Check correct call structure
-	if (argc != 1) {
-		printf(OPERANDS_SURPLUS_MSG,argv[0]);
+	if (invalid_option != NULL) {
+		printf(OPERANDS_INVALID_MSG,invalid_option,argv[0]);
 		fflush(stdout);
-		return (program_end(-1,-1,"",0,"")); // Unmap, close and unlink mmap file & Restore signal handler.
+		return (program_end(-1,signal_fd)); // Restore signal handler.
 	}
-	// 2. Enter an infinite loop, sleeping 2 seconds in each iteration
-	while (finish_loop_and_exit) {
-		sleep(2);
+	if ((res = map_options_finish(&map_options)) != 0) {
+		fprintf(stderr,F_ERROR_STAT_MSG,map_options.folder,strerror(res));
+		return (program_end(res,signal_fd)); // Restore signal handler.
 	}
-	return exit_with_error;
+	if ((signal_fd = signalfd(-1,&sigmask_events,SFD_CLOEXEC)) == -1) { // On success, signalfd() returns a signalfd file descriptor. On error, -1 is returned and errno is set to indicate the error.
+		fprintf(stderr,F_ERROR_SIGNALFD_MSG,strerror(errno));
+		return (program_end(errno,signal_fd)); // Restore signal handler.
+	}
+	// 2. Wait for events. read() returns as soon as the writer's kill() is delivered, no polling interval
+	do {
+		if (read(signal_fd,&event,sizeof(event)) != sizeof(event)) { // On success, read() returns the number of bytes read. On error, -1 is returned and errno is set to indicate the error.
+			if (errno == EINTR) {
+				continue;
+			}
+			fprintf(stderr,F_ERROR_READ_SIGNALFD_MSG,strerror(errno));
+			return (program_end(errno,signal_fd)); // Restore signal handler.
+		}
+		if (event.ssi_signo == SIGINT) { // Only in '--loop' mode
+			break;
+		}
+		// Upon receiving a SIGUSR1 signal:
+		res = process_handoff();
+	} while ((keep_serving)&&(res == 0));
+	// 9. Cleanup. Exit gracefully (man 3 exit)
+	return (program_end(res,signal_fd)); // Restore signal handler.
 }
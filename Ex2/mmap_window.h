@@ -0,0 +1,105 @@
+#ifndef MMAP_WINDOW_H
+#define MMAP_WINDOW_H
+
+// Mapping options shared by mmap_writer and mmap_reader, and the helper that maps one window of the file
+// with them. Both programs must be started with the same '--hugetlb=' folder.
+//   --window=BYTES   Map, process and unmap the file BYTES at a time (rounded up to the page size)
+//   --populate       Prefault every window with MAP_POPULATE, the faults are paid inside mmap()
+//   --thp            Ask for transparent huge pages with MADV_HUGEPAGE (tmpfs mounted with huge=)
+//   --hugetlb=DIR    Put the file in DIR, a hugetlbfs mount. Sizes and offsets are rounded to its page size
+
+#include <errno.h> // errno
+#include <limits.h> // LLONG_MAX
+#include <stdlib.h> // strtoll
+#include <string.h> // strcmp, strncmp
+#include <unistd.h> // _SC_PAGESIZE, sysconf
+#include <sys/mman.h> // MAP_SHARED, MAP_POPULATE, MAP_FAILED, MADV_SEQUENTIAL, MADV_HUGEPAGE, mmap, madvise
+#include <sys/vfs.h> // struct statfs, statfs
+#include "perf_counters.h" // perf_now, perf_elapsed_ms, perf_thread_faults
+
+#define WINDOW_DEFAULT (64LL*1024*1024) // 64MB windows keep RSS bounded for any file size
+
+// Define printing strings
+#define MAP_STATS_MSG			"Mapping took %f milliseconds with %ld page faults, %ld more page faults while touching the data\n"
+
+typedef struct map_options {
+	int populate; // '--populate'
+	int thp; // '--thp'
+	const char *folder; // '--hugetlb=', NULL to use the default folder
+	long long align; // Page size of the file system holding the file, offsets and sizes are multiples of it
+	long long window_size; // '--window=', a multiple of 'align'
+} map_options_t;
+
+typedef struct map_stats {
+	double map_time; // Milliseconds spent in mmap() and madvise(), with '--populate' this includes the faults
+	long map_faults; // Page faults taken inside mmap() and madvise()
+	long touch_faults; // Page faults taken while reading or writing the mapped data
+} map_stats_t;
+
+static inline void map_options_init(map_options_t *options) {
+	options->populate = 0;
+	options->thp = 0;
+	options->folder = NULL;
+	options->align = sysconf(_SC_PAGESIZE);
+	options->window_size = WINDOW_DEFAULT;
+}
+// map_options_parse - returns 1 if 'arg' is a mapping option, 0 if it is not, -1 if it is but its value is invalid
+static inline int map_options_parse(map_options_t *options, const char *arg) {
+	char *endptr; // strtoll var
+	if (strcmp(arg,"--populate") == 0) {
+		options->populate = 1;
+	} else if (strcmp(arg,"--thp") == 0) {
+		options->thp = 1;
+	} else if (strncmp(arg,"--hugetlb=",10) == 0) {
+		options->folder = arg+10;
+		if (options->folder[0] == '\0') {
+			return -1;
+		}
+	} else if (strncmp(arg,"--window=",9) == 0) {
+		errno = 0;
+		options->window_size = strtoll(arg+9, &endptr, 10); // If an overflow occurs, strtoll() returns LLONG_MAX and errno is set to ERANGE.
+		if ((errno != 0)||(endptr == arg+9)||(*endptr != '\0')||(options->window_size < 1)) {
+			return -1;
+		}
+	} else {
+		return 0;
+	}
+	return 1;
+}
+// map_options_finish - called once every option was parsed. Returns 0, or errno if statfs() on the hugetlbfs folder failed
+static inline int map_options_finish(map_options_t *options) {
+	struct statfs folder_stat;
+	if (options->folder != NULL) {
+		if (statfs(options->folder,&folder_stat) == -1) { // On success, zero is returned. On error, -1 is returned, and errno is set appropriately.
+			return errno;
+		}
+		options->align = folder_stat.f_bsize; // On hugetlbfs the block size is the huge page size
+	}
+	if (LLONG_MAX-options->align < options->window_size) {
+		options->window_size = LLONG_MAX-options->align;
+	}
+	options->window_size = ((options->window_size+options->align-1)/options->align)*options->align; // mmap() offsets must be aligned
+	return 0;
+}
+static inline long long map_options_round(const map_options_t *options, long long size) {
+	return ((size+options->align-1)/options->align)*options->align;
+}
+// map_window - mmap() 'len' bytes at 'offset' with the options, and account the time and faults to 'stats'
+static inline char *map_window(int fd, size_t len, long long offset, int prot, const map_options_t *options, map_stats_t *stats) {
+	char *arr;
+	long faults = perf_thread_faults();
+	struct timespec t_start,t_end;
+	perf_now(&t_start);
+	if ((arr = (char*) mmap(NULL,len,prot,MAP_SHARED | (options->populate ? MAP_POPULATE : 0),fd,offset)) != MAP_FAILED) { // On success, mmap() returns a pointer to the mapped area. On error, the value MAP_FAILED ... is returned, and errno is set appropriately.
+		madvise(arr,len,MADV_SEQUENTIAL); // Only a hint, aggressive read ahead of the next pages
+		if (options->thp) {
+			madvise(arr,len,MADV_HUGEPAGE); // Only a hint, fails on file systems without THP support
+		}
+	}
+	perf_now(&t_end);
+	stats->map_time += perf_elapsed_ms(&t_start,&t_end);
+	stats->map_faults += perf_thread_faults()-faults;
+	return arr;
+}
+
+#endif
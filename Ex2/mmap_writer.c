@@ -1,25 +1,35 @@
-#define _POSIX_SOURCE
+#define _GNU_SOURCE
+#define _FILE_OFFSET_BITS 64 // 64-bit off_t for lseek() and mmap() offsets, also on 32-bit hosts
 #include <errno.h> // errno
 #include <fcntl.h> // O_RDWR, O_CREAT, O_TRUNC, open
-#include <limits.h> // LONG_MAX, LONG_MIN
+#include <limits.h> // LONG_MAX, LONG_MIN, LLONG_MAX, LLONG_MIN
 #include <signal.h> // SIG_IGN, SIGUSR1, SIGTERM, struct sigaction, sigaction, sigemptyset, kill
 #include <stdio.h> // printf, fprintf, snprintf, stdout, stderr, fflush, perror
-#include <stdlib.h> // EXIT_FAILURE, EXIT_SUCCESS, strtol
-#include <string.h> // strlen, strerror, memset
+#include <stdlib.h> // EXIT_FAILURE, EXIT_SUCCESS, strtol, strtoll
+#include <string.h> // strlen, strcmp, strncmp, strerror, memset
 #include <sys/stat.h> // chmod
-#include <sys/time.h> // gettimeofday, struct timeval
-#include <unistd.h> // EACCES, ENOENT, R_OK, W_OK, lseek, write, close, access
-#include <sys/mman.h> // PROT_WRITE, MAP_SHARED, MAP_FAILED, MS_SYNC, mmap, munmap, msync
+#include <unistd.h> // EACCES, ENOENT, R_OK, W_OK, lseek, write, ftruncate, close, access
+#include <sys/mman.h> // PROT_WRITE, MAP_FAILED, MS_SYNC, MS_ASYNC, MADV_DONTNEED, madvise, munmap, msync
+#include "mmap_window.h" // map_options_t, map_stats_t, map_options_init, map_options_parse, map_options_finish, map_options_round, map_window
+#include "perf_counters.h" // perf_region_t, perf_now, perf_elapsed_ms, perf_thread_faults, perf_region_start, perf_region_stop, perf_region_ms, perf_region_print
+#include "simd_bytes.h" // fill_bytes
 
 #define TMP_FOLDER "./tmp"
 #define FILE_NAME "mmapped.bin"
 
+// msync() policy, set with '--sync='
+#define SYNC_NONE	0 // Do not flush, the reader sees the data through the shared page cache anyway
+#define SYNC_ASYNC	1 // Schedule the write back and return (MS_ASYNC)
+#define SYNC_SYNC	2 // Wait until the data is on the disk (MS_SYNC), the default
+
 // Define printing strings
-#define BENCHMARK_MSG			"%d were written in %f milliseconds through MMAP\n"
-#define NUM_LESS_THEN_TWO_MSG		"The input value '%d' is too small\n"
-#define OPERANDS_MISSING_MSG		"Missing operands\nUsage: %s <NUM> <RPID>\n"
-#define OPERANDS_SURPLUS_MSG		"Too many operands\nUsage: %s <NUM> <RPID>\n"
-#define PID_INVALID_MSG			"The process id '%d' is invalid\n"
+#define BENCHMARK_MSG			"%lld were written in %f milliseconds through MMAP\n"
+#define BENCHMARK_PHASES_MSG		"Fill took %f milliseconds, msync(%s) took %f milliseconds\n"
+#define NUM_LESS_THEN_TWO_MSG		"The input value '%lld' is too small\n"
+#define OPERANDS_INVALID_MSG		"Invalid option '%s'\nUsage: %s <NUM> <RPID> [--sync=none|async|sync] [--window=BYTES] [--populate] [--thp] [--hugetlb=DIR]\n"
+#define OPERANDS_MISSING_MSG		"Missing operands\nUsage: %s <NUM> <RPID> [--sync=none|async|sync] [--window=BYTES] [--populate] [--thp] [--hugetlb=DIR]\n"
+#define OPERANDS_SURPLUS_MSG		"Too many operands\nUsage: %s <NUM> <RPID> [--sync=none|async|sync] [--window=BYTES] [--populate] [--thp] [--hugetlb=DIR]\n"
+#define PID_INVALID_MSG			"The process id '%ld' is invalid\n"
 #define ERROR_EXIT_MSG			"Exiting...\n"
 #define ERROR_SIGACTION_INIT_MSG	"[Error] Failed to init signal handler (sigaction).\n"
 #define ERROR_SIGACTION_RESTORE_MSG	"[Error] Failed to restore signal handler (sigaction).\n"
@@ -27,21 +37,24 @@
 #define F_ERROR_CHMOD_FILE_MSG		"[Error] Chmod FIFO file '%s': %s\n"
 #define F_ERROR_CLOSE_MMAP_MSG		"[Error] Close mmap file '%s': %s\n"
 #define F_ERROR_OPEN_MMAP_MSG		"[Error] Open mmap file '%s': %s\n"
+#define F_ERROR_STAT_MSG		"[Error] Getting information for file '%s': %s\n"
 #define P_ERROR_LSEAK_MSG		"[Error] Calling lseek() to 'stretch' the file"
 #define P_ERROR_MMAPPING_MSG		"[Error] Mmapping the file"
 #define P_ERROR_MSYNC_MSG		"[Error] Msync failed with error"
 #define P_ERROR_STRTOL_MSG		"[Error] Strtol failed with error"
+#define P_ERROR_TRUNCATE_MSG		"[Error] Calling ftruncate() to 'stretch' the file"
 #define P_ERROR_UNMMAPPING_MSG		"[Error] Un-mmapping the file"
 #define P_ERROR_WRITE_LAST_BYTE_MSG	"[Error] Writing last byte of the file"
 
 struct sigaction sigterm_old_handler;
+const char *sync_names[] = {"none","async","sync"}; // Indexed by SYNC_*
 
 // This file is based on:
 // 1) File name 'memory mapped file demo' on the course module site. (http://moodle.tau.ac.il/course/view.php?id=368216201)
 // 2) Youtube video: https://www.youtube.com/watch?v=F3z-SIxu1Tw
-int program_end(int error, int fd, char *location, int mmap_size, char *arr) {
+int program_end(int error, int fd, char *location, size_t map_len, char *arr) {
 	int res = 0;
-	if ((0 < mmap_size)&&(munmap(arr,mmap_size) == -1)) { // returns 0, on failure -1, and errno is set (probably to EINVAL)
+	if ((0 < map_len)&&(munmap(arr,map_len) == -1)) { // returns 0, on failure -1, and errno is set (probably to EINVAL)
 		perror(P_ERROR_UNMMAPPING_MSG);
 		res = errno;
 	}
@@ -66,14 +79,27 @@ int main(int argc, char *argv[]) {
 	// General variable
 	char *arr;
 	char *endptr; // strtol var
-	char mmap_location[strlen(TMP_FOLDER)+strlen(FILE_NAME)+2]; // The location of the mmap file in the file system
-	mmap_location[0] = '\0';
+	char *operands[2]; // <NUM> <RPID>
+	char *mmap_location = ""; // The location of the mmap file in the file system, set once the folder is known
+	const char *folder;
 	double elapsed_time;
+	double fill_time = 0;
+	double sync_time = 0;
 	int i;
 	int mmap_fd = -1; // The descriptor of the mmap file
-	long mmap_size;
+	int operands_count = 0;
+	int res;
+	int sync_policy = SYNC_SYNC;
+	long faults;
+	long long file_size; // 'mmap_size', rounded up to the huge page size with '--hugetlb='
+	long long mmap_size;
+	long long offset;
 	long reader_pid;
-	struct timeval t_start,t_end;
+	map_options_t map_options; // '--window=', '--populate', '--thp' and '--hugetlb='
+	map_stats_t map_stats = {0,0,0};
+	size_t map_len;
+	perf_region_t region;
+	struct timespec t_window,t_fill,t_sync;
 	struct sigaction sigterm_new_handler;
 	// Create signal handlers
 	//memset(&sigterm_new_handler, 0, sizeof(sigterm_new_handler)); // We were not allowed to use memset,
@@ -86,8 +112,34 @@ int main(int argc, char *argv[]) {
 		return (EXIT_FAILURE);
 	}
 	// Check correct call structure
-	if (argc != 3) {
-		if (argc < 3) {
+	map_options_init(&map_options);
+	for (i = 1; i < argc; i++) {
+		if (strncmp(argv[i],"--sync=",7) == 0) {
+			for (sync_policy = SYNC_SYNC; 0 <= sync_policy; sync_policy--) {
+				if (strcmp(argv[i]+7,sync_names[sync_policy]) == 0) {
+					break;
+				}
+			}
+			if (sync_policy < 0) {
+				printf(OPERANDS_INVALID_MSG,argv[i],argv[0]);
+				fflush(stdout);
+				return (program_end(-1,mmap_fd,mmap_location,0,"")); // Unmap and close mmap file & Restore signal handler.
+			}
+		} else if ((res = map_options_parse(&map_options,argv[i])) != 0) {
+			if (res == -1) {
+				printf(OPERANDS_INVALID_MSG,argv[i],argv[0]);
+				fflush(stdout);
+				return (program_end(-1,mmap_fd,mmap_location,0,"")); // Unmap and close mmap file & Restore signal handler.
+			}
+		} else if (operands_count < 2) {
+			operands[operands_count] = argv[i];
+			operands_count += 1;
+		} else {
+			operands_count += 1; // Too many operands
+		}
+	}
+	if (operands_count != 2) {
+		if (operands_count < 2) {
 			printf(OPERANDS_MISSING_MSG,argv[0]);
 		} else {
 			printf(OPERANDS_SURPLUS_MSG,argv[0]);
@@ -95,12 +147,12 @@ int main(int argc, char *argv[]) {
 		fflush(stdout);
 		return (program_end(-1,mmap_fd,mmap_location,0,"")); // Unmap and close mmap file & Restore signal handler.
 	}
-	mmap_size = strtol(argv[1], &endptr, 10); // If an underflow occurs. strtol() returns LONG_MIN.  If an overflow occurs, strtol() returns LONG_MAX. In both cases, errno is set to ERANGE.
-	if ((errno == ERANGE && (mmap_size == LONG_MAX || mmap_size == LONG_MIN)) || (errno != 0 && mmap_size == 0)) {
+	mmap_size = strtoll(operands[0], &endptr, 10); // If an underflow occurs. strtoll() returns LLONG_MIN.  If an overflow occurs, strtoll() returns LLONG_MAX. In both cases, errno is set to ERANGE.
+	if ((errno == ERANGE && (mmap_size == LLONG_MAX || mmap_size == LLONG_MIN)) || (errno != 0 && mmap_size == 0)) {
 		perror("P_ERROR_STRTOL_MSG");
 		return (program_end(errno,mmap_fd,mmap_location,0,"")); // Unmap and close mmap file & Restore signal handler.
 	}
-	if (endptr == argv[1]) { // Empty string
+	if (endptr == operands[0]) { // Empty string
 		printf(OPERANDS_MISSING_MSG,argv[0]);
 		fflush(stdout);
 		return (program_end(-1,mmap_fd,mmap_location,0,"")); // Unmap and close mmap file & Restore signal handler.
@@ -110,12 +162,12 @@ int main(int argc, char *argv[]) {
 		fflush(stdout);
 		return (program_end(-1,mmap_fd,mmap_location,0,"")); // Unmap and close mmap file & Restore signal handler.
 	}
-	reader_pid = strtol(argv[2], &endptr, 10); // If an underflow occurs. strtol() returns LONG_MIN.  If an overflow occurs, strtol() returns LONG_MAX. In both cases, errno is set to ERANGE.
+	reader_pid = strtol(operands[1], &endptr, 10); // If an underflow occurs. strtol() returns LONG_MIN.  If an overflow occurs, strtol() returns LONG_MAX. In both cases, errno is set to ERANGE.
 	if ((errno == ERANGE && (reader_pid == LONG_MAX || reader_pid == LONG_MIN)) || (errno != 0 && reader_pid == 0)) {
 		perror("P_ERROR_STRTOL_MSG");
 		return (program_end(errno,mmap_fd,mmap_location,0,"")); // Unmap and close mmap file & Restore signal handler.
 	}
-	if (endptr == argv[2]) { // Empty string
+	if (endptr == operands[1]) { // Empty string
 		printf(OPERANDS_MISSING_MSG,argv[0]);
 		fflush(stdout);
 		return (program_end(-1,mmap_fd,mmap_location,0,"")); // Unmap and close mmap file & Restore signal handler.
@@ -125,9 +177,16 @@ int main(int argc, char *argv[]) {
 		fflush(stdout);
 		return (program_end(-1,mmap_fd,mmap_location,0,"")); // Unmap and close mmap file & Restore signal handler.
 	}
-	// 1. Create a file under the /tmp directory named mmapped.bin
+	if ((res = map_options_finish(&map_options)) != 0) {
+		fprintf(stderr,F_ERROR_STAT_MSG,map_options.folder,strerror(res));
+		return (program_end(res,mmap_fd,mmap_location,0,"")); // Unmap and close mmap file & Restore signal handler.
+	}
+	// 1. Create a file under the /tmp directory (or the '--hugetlb=' folder) named mmapped.bin
 	// 2. Set the file permissions to 0600 (man 2 chmod)
-	snprintf(mmap_location,sizeof(mmap_location),"%s/%s",TMP_FOLDER,FILE_NAME); // Set 'mmap_location' to be the path to the communication file
+	folder = (map_options.folder != NULL) ? map_options.folder : TMP_FOLDER;
+	char mmap_path[strlen(folder)+strlen(FILE_NAME)+2];
+	snprintf(mmap_path,sizeof(mmap_path),"%s/%s",folder,FILE_NAME); // Set 'mmap_location' to be the path to the communication file
+	mmap_location = mmap_path;
 	if (access(mmap_location,R_OK | W_OK) == -1) {// On success ..., zero is returned. On error ..., -1 is returned, and errno is set appropriately.
 		if (errno == EACCES) { // The requested access would be denied to the file, or search permission is denied for one of the directories in the path prefix of pathname.
 			if (chmod(mmap_location, 0600) == -1) { // On success, zero is returned.  On error, -1 is returned, and errno is set appropriately.
@@ -143,37 +202,66 @@ int main(int argc, char *argv[]) {
 		fprintf(stderr,F_ERROR_OPEN_MMAP_MSG,mmap_location,strerror(errno)); // No need to call fflush(stderr);
 		return (program_end(errno,mmap_fd,mmap_location,0,"")); // Unmap and close mmap file & Restore signal handler.
 	}
-	if (lseek(mmap_fd,mmap_size-1,SEEK_SET) != (mmap_size-1)) { // Change file size to be NUM (argv[1])
-		perror(P_ERROR_LSEAK_MSG);
-		return (program_end(-1,mmap_fd,mmap_location,0,"")); // Unmap and close mmap file & Restore signal handler.
-	}
-	if (write(mmap_fd,"",1) != 1) {
-		perror(P_ERROR_WRITE_LAST_BYTE_MSG);
-		return (program_end(-1,mmap_fd,mmap_location,0,"")); // Unmap and close mmap file & Restore signal handler.
-	}
-	// 3. Create a memory map for the file
-	if ((arr = (char*) mmap(NULL,mmap_size,PROT_WRITE,MAP_SHARED,mmap_fd,0)) == MAP_FAILED) { // On success, mmap() returns a pointer to the mapped area. On error, the value MAP_FAILED ... is returned, and errno is set appropriately.
-		perror(P_ERROR_MMAPPING_MSG);
-		return (program_end(errno,mmap_fd,mmap_location,0,"")); // Unmap and close mmap file & Restore signal handler.
+	if (map_options.folder != NULL) { // hugetlbfs does not support write(), and its files are a whole number of huge pages
+		file_size = map_options_round(&map_options,mmap_size);
+		if (ftruncate(mmap_fd,file_size) == -1) { // On success, zero is returned. On error, -1 is returned, and errno is set appropriately.
+			perror(P_ERROR_TRUNCATE_MSG);
+			return (program_end(errno,mmap_fd,mmap_location,0,"")); // Unmap and close mmap file & Restore signal handler.
+		}
+	} else {
+		file_size = mmap_size;
+		if (lseek(mmap_fd,mmap_size-1,SEEK_SET) != (mmap_size-1)) { // Change file size to be NUM (argv[1])
+			perror(P_ERROR_LSEAK_MSG);
+			return (program_end(-1,mmap_fd,mmap_location,0,"")); // Unmap and close mmap file & Restore signal handler.
+		}
+		if (write(mmap_fd,"",1) != 1) {
+			perror(P_ERROR_WRITE_LAST_BYTE_MSG);
+			return (program_end(-1,mmap_fd,mmap_location,0,"")); // Unmap and close mmap file & Restore signal handler.
+		}
 	}
+	// 3. Create a memory map for the file, one window at a time
 	// 4. Start the time measurement
-	gettimeofday(&t_start,NULL);
+	perf_region_start(&region);
 	// 5. Fill the array with NUM-1 sequential 'a' bytes and then NULL (i.e., '\0')
-	for (i = 0; i < mmap_size-1; i++) { // Write to the file
-		arr[i] = 'a';
-	}
-	arr[mmap_size-1] = '\0';
-	if (msync(arr,mmap_size,MS_SYNC) == -1) { // On success, zero is returned.  On error, -1 is returned, and errno is set appropriately.
-		perror(P_ERROR_MSYNC_MSG);
-		return (program_end(errno,mmap_fd,mmap_location,mmap_size,arr)); // Unmap and close mmap file & Restore signal handler.
+	for (offset = 0; offset < file_size; offset += map_len) {
+		map_len = ((file_size-offset) < map_options.window_size) ? (size_t)(file_size-offset) : (size_t)map_options.window_size;
+		if ((arr = map_window(mmap_fd,map_len,offset,PROT_WRITE,&map_options,&map_stats)) == MAP_FAILED) {
+			perror(P_ERROR_MMAPPING_MSG);
+			return (program_end(errno,mmap_fd,mmap_location,0,"")); // Unmap and close mmap file & Restore signal handler.
+		}
+		faults = perf_thread_faults();
+		perf_now(&t_window);
+		if (offset+(long long)map_len < mmap_size) {
+			fill_bytes(arr,map_len,'a'); // Write to the file, large sizes bypass the cache with streaming stores
+		} else { // Last window, with '--hugetlb=' the bytes after the NULL stay zero
+			fill_bytes(arr,mmap_size-1-offset,'a');
+			arr[mmap_size-1-offset] = '\0';
+		}
+		perf_now(&t_fill);
+		map_stats.touch_faults += perf_thread_faults()-faults;
+		if ((sync_policy != SYNC_NONE)&&(msync(arr,map_len,(sync_policy == SYNC_SYNC) ? MS_SYNC : MS_ASYNC) == -1)) { // On success, zero is returned.  On error, -1 is returned, and errno is set appropriately.
+			perror(P_ERROR_MSYNC_MSG);
+			return (program_end(errno,mmap_fd,mmap_location,map_len,arr)); // Unmap and close mmap file & Restore signal handler.
+		}
+		perf_now(&t_sync);
+		fill_time += perf_elapsed_ms(&t_window,&t_fill);
+		sync_time += perf_elapsed_ms(&t_fill,&t_sync);
+		madvise(arr,map_len,MADV_DONTNEED); // Only a hint, the dirty pages stay in the shared page cache but leave our RSS
+		if (munmap(arr,map_len) == -1) { // returns 0, on failure -1, and errno is set (probably to EINVAL)
+			perror(P_ERROR_UNMMAPPING_MSG);
+			return (program_end(errno,mmap_fd,mmap_location,0,"")); // Close mmap file & Restore signal handler.
+		}
 	}
 	// 6. Send a signal (SIGUSR1) to the reader process (man 2 kill)
 	kill(reader_pid, SIGUSR1);
 	// 7. Print the measurement result together with the number of bytes written
-	gettimeofday(&t_end,NULL);
-	elapsed_time = ((t_end.tv_sec-t_start.tv_sec)*1000.0) + ((t_end.tv_usec-t_start.tv_usec)/1000.0);
+	perf_region_stop(&region);
+	elapsed_time = perf_region_ms(&region);
 	printf(BENCHMARK_MSG,mmap_size,elapsed_time);
+	printf(BENCHMARK_PHASES_MSG,fill_time,sync_names[sync_policy],sync_time);
+	perf_region_print(stdout,&region);
+	printf(MAP_STATS_MSG,map_stats.map_time,map_stats.map_faults,map_stats.touch_faults);
 	fflush(stdout);
 	// 8. Cleanup. Exit gracefully
-	return (program_end(0,mmap_fd,mmap_location,mmap_size,arr)); // Unmap and close mmap file & Restore signal handler.
+	return (program_end(0,mmap_fd,mmap_location,0,"")); // Close mmap file & Restore signal handler.
 }
@@ -0,0 +1,121 @@
+#ifndef PERF_COUNTERS_H
+#define PERF_COUNTERS_H
+
+// Hardware and software counters around the measured regions of the Ex2 programs.
+// perf_region_start() opens the counters with perf_event_open(2) and takes a CLOCK_MONOTONIC timestamp,
+// perf_region_stop() takes the second timestamp and reads the counters. When perf events are not permitted
+// (see /proc/sys/kernel/perf_event_paranoid) or not supported (e.g. in a VM) the missing counters print as
+// 'n/a' and only the timing is reported.
+
+#include <errno.h> // EACCES, EPERM, errno
+#include <stdio.h> // FILE, fprintf
+#include <string.h> // memset
+#include <time.h> // CLOCK_MONOTONIC, struct timespec, clock_gettime
+#include <sys/resource.h> // RUSAGE_THREAD, struct rusage, getrusage
+#include <unistd.h> // syscall, read, close
+#include <sys/ioctl.h> // ioctl
+#include <sys/syscall.h> // SYS_perf_event_open
+#include <linux/perf_event.h> // PERF_*, struct perf_event_attr
+
+#define PERF_COUNTERS_COUNT	5
+#define PERF_CYCLES		0
+#define PERF_INSTRUCTIONS	1
+#define PERF_PAGE_FAULTS	2
+#define PERF_CONTEXT_SWITCHES	3
+#define PERF_CACHE_MISSES	4
+
+// Define printing strings
+#define PERF_MSG		"Counters: cycles %s, instructions %s, IPC %s, page faults %s, context switches %s, cache misses %s\n"
+#define PERF_NA			"n/a"
+
+typedef struct perf_region {
+	int fds[PERF_COUNTERS_COUNT]; // -1 if the counter could not be opened
+	unsigned long long values[PERF_COUNTERS_COUNT];
+	struct timespec t_start;
+	struct timespec t_end;
+} perf_region_t;
+
+static inline void perf_now(struct timespec *t) {
+	clock_gettime(CLOCK_MONOTONIC,t); // Not affected by NTP steps or settimeofday(), unlike gettimeofday()
+}
+static inline double perf_elapsed_ms(const struct timespec *t_start, const struct timespec *t_end) {
+	return ((t_end->tv_sec-t_start->tv_sec)*1000.0) + ((t_end->tv_nsec-t_start->tv_nsec)/1000000.0);
+}
+static inline long perf_thread_faults(void) { // Minor + major page faults of the calling thread so far
+	struct rusage usage;
+	if (getrusage(RUSAGE_THREAD,&usage) == -1) { // On success, zero is returned. On error, -1 is returned, and errno is set appropriately.
+		return 0;
+	}
+	return usage.ru_minflt+usage.ru_majflt;
+}
+static inline int perf_counter_open(unsigned int type, unsigned long long config) {
+	int fd;
+	struct perf_event_attr attr;
+	memset(&attr,0,sizeof(attr));
+	attr.size = sizeof(attr);
+	attr.type = type;
+	attr.config = config;
+	attr.disabled = 1; // Enabled by perf_region_start() once every counter is open
+	attr.inherit = 1; // Also count threads created inside the region (mmap_reader -j)
+	attr.exclude_hv = 1;
+	if ((fd = syscall(SYS_perf_event_open,&attr,0,-1,-1,0)) == -1) { // Returns the new file descriptor, or -1 if an error occurred (in which case, errno is set appropriately).
+		if ((errno == EACCES)||(errno == EPERM)) { // perf_event_paranoid >= 2 only allows user space counting
+			attr.exclude_kernel = 1;
+			fd = syscall(SYS_perf_event_open,&attr,0,-1,-1,0);
+		}
+	}
+	return fd;
+}
+static inline void perf_region_start(perf_region_t *region) {
+	int i;
+	region->fds[PERF_CYCLES] = perf_counter_open(PERF_TYPE_HARDWARE,PERF_COUNT_HW_CPU_CYCLES);
+	region->fds[PERF_INSTRUCTIONS] = perf_counter_open(PERF_TYPE_HARDWARE,PERF_COUNT_HW_INSTRUCTIONS);
+	region->fds[PERF_PAGE_FAULTS] = perf_counter_open(PERF_TYPE_SOFTWARE,PERF_COUNT_SW_PAGE_FAULTS);
+	region->fds[PERF_CONTEXT_SWITCHES] = perf_counter_open(PERF_TYPE_SOFTWARE,PERF_COUNT_SW_CONTEXT_SWITCHES);
+	region->fds[PERF_CACHE_MISSES] = perf_counter_open(PERF_TYPE_HARDWARE,PERF_COUNT_HW_CACHE_MISSES);
+	for (i = 0; i < PERF_COUNTERS_COUNT; i++) {
+		region->values[i] = 0;
+		if (region->fds[i] != -1) {
+			ioctl(region->fds[i],PERF_EVENT_IOC_RESET,0);
+			ioctl(region->fds[i],PERF_EVENT_IOC_ENABLE,0);
+		}
+	}
+	perf_now(&region->t_start);
+}
+static inline void perf_region_stop(perf_region_t *region) {
+	int i;
+	perf_now(&region->t_end);
+	for (i = 0; i < PERF_COUNTERS_COUNT; i++) {
+		if (region->fds[i] != -1) {
+			ioctl(region->fds[i],PERF_EVENT_IOC_DISABLE,0);
+			if (read(region->fds[i],&region->values[i],sizeof(region->values[i])) != sizeof(region->values[i])) {
+				close(region->fds[i]); // Report it as not available
+				region->fds[i] = -1;
+				continue;
+			}
+			close(region->fds[i]);
+			region->fds[i] = -2; // Read and closed
+		}
+	}
+}
+static inline double perf_region_ms(const perf_region_t *region) {
+	return perf_elapsed_ms(&region->t_start,&region->t_end);
+}
+static inline void perf_region_print(FILE *stream, const perf_region_t *region) {
+	char values[PERF_COUNTERS_COUNT][24];
+	char ipc[24] = PERF_NA;
+	int i;
+	for (i = 0; i < PERF_COUNTERS_COUNT; i++) {
+		if (region->fds[i] == -1) {
+			snprintf(values[i],sizeof(values[i]),PERF_NA);
+		} else {
+			snprintf(values[i],sizeof(values[i]),"%llu",region->values[i]);
+		}
+	}
+	if ((region->fds[PERF_CYCLES] != -1)&&(region->fds[PERF_INSTRUCTIONS] != -1)&&(0 < region->values[PERF_CYCLES])) {
+		snprintf(ipc,sizeof(ipc),"%.2f",(double)region->values[PERF_INSTRUCTIONS]/region->values[PERF_CYCLES]);
+	}
+	fprintf(stream,PERF_MSG,values[PERF_CYCLES],values[PERF_INSTRUCTIONS],ipc,values[PERF_PAGE_FAULTS],values[PERF_CONTEXT_SWITCHES],values[PERF_CACHE_MISSES]);
+}
+
+#endif
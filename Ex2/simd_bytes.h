@@ -0,0 +1,202 @@
+#ifndef SIMD_BYTES_H
+#define SIMD_BYTES_H
+
+// Vectorized byte kernels shared by the Ex2 readers and writers.
+// Every program in Ex2 is built from a single source file (gcc -O3 -Wall -std=gnu99 prog.c), so the kernels
+// are 'static' and live in this header. On x86 with SSE2 (every x86-64, i386 only with -msse2) the best
+// implementation (AVX2 / SSE2 / scalar) is picked once at runtime with __builtin_cpu_supports(), other
+// architectures and i386 builds without SSE2 always use the scalar code.
+
+#include <stddef.h> // size_t
+#include <stdint.h> // uintptr_t
+#include <string.h> // memset
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__SSE2__)
+#	define SIMD_BYTES_X86 1
+#	include <immintrin.h> // __m128i, __m256i, _mm_*, _mm256_*
+#endif
+
+#define SCAN_NO_TERMINATOR	-1	// Pass as 'terminator' when every byte that is not 'target' is invalid
+#define FILL_STREAM_MIN		(4*1024*1024)	// Below this size the data fits in the cache and memset() is faster
+
+typedef struct scan_result {
+	long long count; // Number of 'target' bytes before the stop position
+	long long stop; // Offset of the first terminator or invalid byte, -1 if the whole buffer is valid
+	int stop_char; // The byte found at 'stop' (only valid if 0 <= stop)
+	int invalid; // 1 if 'stop' points to an invalid byte (not 'target' and not 'terminator')
+} scan_result_t;
+
+typedef void (*scan_kernel_t)(const char *buf, size_t len, char target, int terminator, scan_result_t *res);
+typedef void (*fill_kernel_t)(char *buf, size_t len, char value);
+
+// Finish a block in which 'stop_mask' (bit i = byte i is not 'target') is not empty.
+static inline void scan_block_stop(const char *block, long long offset, unsigned int target_mask, unsigned int stop_mask, int terminator, scan_result_t *res) {
+	int first = __builtin_ctz(stop_mask);
+	res->count += __builtin_popcount(target_mask & ((1u << first) - 1)); // 'first' < 32, so the shift is defined
+	res->stop = offset + first;
+	res->stop_char = (unsigned char)block[first];
+	res->invalid = (res->stop_char != terminator);
+}
+static inline void scan_bytes_scalar(const char *buf, size_t len, char target, int terminator, scan_result_t *res) {
+	size_t i;
+	res->count = 0;
+	res->stop = -1;
+	res->stop_char = 0;
+	res->invalid = 0;
+	for (i = 0; i < len; i++) {
+		if (buf[i] != target) {
+			res->stop = i;
+			res->stop_char = (unsigned char)buf[i];
+			res->invalid = (res->stop_char != terminator);
+			return;
+		}
+		res->count += 1;
+	}
+}
+#ifdef SIMD_BYTES_X86
+static inline void scan_bytes_sse2(const char *buf, size_t len, char target, int terminator, scan_result_t *res) {
+	const __m128i v_target = _mm_set1_epi8(target);
+	unsigned int target_mask;
+	size_t i = 0;
+	scan_result_t tail;
+	res->count = 0;
+	res->stop = -1;
+	res->stop_char = 0;
+	res->invalid = 0;
+	for (; i + 16 <= len; i += 16) {
+		target_mask = (unsigned int)_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *)(buf + i)), v_target));
+		if (target_mask != 0xFFFF) { // Something that is not 'target' in this block
+			scan_block_stop(buf + i, i, target_mask, ~target_mask & 0xFFFF, terminator, res);
+			return;
+		}
+		res->count += 16;
+	}
+	scan_bytes_scalar(buf + i, len - i, target, terminator, &tail); // Less than one vector is left
+	res->count += tail.count;
+	if (0 <= tail.stop) {
+		res->stop = i + tail.stop;
+		res->stop_char = tail.stop_char;
+		res->invalid = tail.invalid;
+	}
+}
+__attribute__((target("avx2,popcnt")))
+static inline void scan_bytes_avx2(const char *buf, size_t len, char target, int terminator, scan_result_t *res) {
+	const __m256i v_target = _mm256_set1_epi8(target);
+	unsigned int mask_lo, mask_hi;
+	size_t i = 0;
+	scan_result_t tail;
+	res->count = 0;
+	res->stop = -1;
+	res->stop_char = 0;
+	res->invalid = 0;
+	for (; i + 64 <= len; i += 64) { // Two vectors per iteration to keep both load ports busy
+		mask_lo = (unsigned int)_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i *)(buf + i)), v_target));
+		mask_hi = (unsigned int)_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i *)(buf + i + 32)), v_target));
+		if ((mask_lo & mask_hi) != 0xFFFFFFFFu) {
+			if (mask_lo != 0xFFFFFFFFu) {
+				scan_block_stop(buf + i, i, mask_lo, ~mask_lo, terminator, res);
+			} else {
+				res->count += 32;
+				scan_block_stop(buf + i + 32, i + 32, mask_hi, ~mask_hi, terminator, res);
+			}
+			return;
+		}
+		res->count += 64;
+	}
+	scan_bytes_sse2(buf + i, len - i, target, terminator, &tail);
+	res->count += tail.count;
+	if (0 <= tail.stop) {
+		res->stop = i + tail.stop;
+		res->stop_char = tail.stop_char;
+		res->invalid = tail.invalid;
+	}
+}
+// Streaming (non-temporal) stores bypass the cache: a multi-MB fill would otherwise evict everything and pay
+// a read-for-ownership for every cache line it is about to overwrite anyway.
+static inline void fill_bytes_sse2(char *buf, size_t len, char value) {
+	const __m128i v_value = _mm_set1_epi8(value);
+	size_t head = (16 - ((uintptr_t)buf & 15)) & 15; // Bytes until the first 16B aligned address
+	size_t i;
+	if (len < head + 16) {
+		memset(buf, value, len);
+		return;
+	}
+	memset(buf, value, head);
+	for (i = head; i + 16 <= len; i += 16) {
+		_mm_stream_si128((__m128i *)(buf + i), v_value);
+	}
+	_mm_sfence(); // Order the weakly ordered stores before anyone is told the data is ready
+	memset(buf + i, value, len - i);
+}
+__attribute__((target("avx2")))
+static inline void fill_bytes_avx2(char *buf, size_t len, char value) {
+	const __m256i v_value = _mm256_set1_epi8(value);
+	size_t head = (32 - ((uintptr_t)buf & 31)) & 31; // Bytes until the first 32B aligned address
+	size_t i;
+	if (len < head + 128) {
+		memset(buf, value, len);
+		return;
+	}
+	memset(buf, value, head);
+	for (i = head; i + 128 <= len; i += 128) { // Two full cache lines per iteration
+		_mm256_stream_si256((__m256i *)(buf + i), v_value);
+		_mm256_stream_si256((__m256i *)(buf + i + 32), v_value);
+		_mm256_stream_si256((__m256i *)(buf + i + 64), v_value);
+		_mm256_stream_si256((__m256i *)(buf + i + 96), v_value);
+	}
+	_mm_sfence();
+	memset(buf + i, value, len - i);
+}
+#endif
+static inline void fill_bytes_memset(char *buf, size_t len, char value) {
+	memset(buf, value, len);
+}
+static inline scan_kernel_t scan_bytes_select(void) {
+#ifdef SIMD_BYTES_X86
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("popcnt")) {
+		return scan_bytes_avx2;
+	}
+	return scan_bytes_sse2; // SSE2 is part of the x86-64 baseline
+#else
+	return scan_bytes_scalar;
+#endif
+}
+// scan_bytes - count 'target' bytes from the start of 'buf' until the first byte that is not 'target'.
+// That byte is either the 'terminator' (res->invalid == 0) or an invalid byte (res->invalid == 1).
+static inline void scan_bytes(const char *buf, size_t len, char target, int terminator, scan_result_t *res) {
+	static scan_kernel_t kernel = NULL; // Threads may pick it at the same time, hence the atomic load and store
+	scan_kernel_t scan = __atomic_load_n(&kernel, __ATOMIC_RELAXED);
+	if (scan == NULL) {
+		scan = scan_bytes_select();
+		__atomic_store_n(&kernel, scan, __ATOMIC_RELAXED);
+	}
+	scan(buf, len, target, terminator, res);
+}
+static inline fill_kernel_t fill_bytes_select(void) {
+#ifdef SIMD_BYTES_X86
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx2")) {
+		return fill_bytes_avx2;
+	}
+	return fill_bytes_sse2;
+#else
+	return fill_bytes_memset;
+#endif
+}
+// fill_bytes - set 'len' bytes of 'buf' to 'value'. Large fills use non-temporal stores, small ones memset().
+static inline void fill_bytes(char *buf, size_t len, char value) {
+	static fill_kernel_t kernel = NULL; // Like scan_bytes(), loaded and stored atomically
+	fill_kernel_t fill;
+	if (len < FILL_STREAM_MIN) {
+		memset(buf, value, len);
+		return;
+	}
+	if ((fill = __atomic_load_n(&kernel, __ATOMIC_RELAXED)) == NULL) {
+		fill = fill_bytes_select();
+		__atomic_store_n(&kernel, fill, __ATOMIC_RELAXED);
+	}
+	fill(buf, len, value);
+}
+
+#endif
@@ -0,0 +1,40 @@
+#ifndef BENCH_REPORT_H
+#define BENCH_REPORT_H
+
+// Helpers for the '--bench' mode of hw3: a monotonic clock, Jain's fairness index and JSON number arrays.
+// Jain's index of x[0..n-1] is (sum x)^2 / (n * sum x^2). It is 1 when every thread got the same share and
+// 1/n when a single thread did all the work.
+
+#include <stdio.h> // FILE, fprintf
+#include <time.h> // CLOCK_MONOTONIC, struct timespec, clock_gettime
+
+static inline void bench_now(struct timespec *t) {
+	clock_gettime(CLOCK_MONOTONIC,t); // Not affected by NTP steps or settimeofday(), unlike gettimeofday()
+}
+static inline double bench_elapsed_ms(const struct timespec *t_start, const struct timespec *t_end) {
+	return ((t_end->tv_sec-t_start->tv_sec)*1000.0) + ((t_end->tv_nsec-t_start->tv_nsec)/1000000.0);
+}
+static inline double bench_jain(const double *x, int n) {
+	double sum = 0;
+	double sum_sq = 0;
+	int i;
+	for (i = 0; i < n; i++) {
+		sum += x[i];
+		sum_sq += x[i]*x[i];
+	}
+	if (sum_sq == 0) { // Nobody did anything, equally
+		return 1;
+	}
+	return (sum*sum)/(n*sum_sq);
+}
+// bench_json_array - print '"name":[x0,x1,...]', rounded to integers
+static inline void bench_json_array(FILE *stream, const char *name, const double *x, int n) {
+	int i;
+	fprintf(stream,"\"%s\":[",name);
+	for (i = 0; i < n; i++) {
+		fprintf(stream,(i == 0) ? "%.0f" : ",%.0f",x[i]);
+	}
+	fprintf(stream,"]");
+}
+
+#endif
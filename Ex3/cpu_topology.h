@@ -0,0 +1,184 @@
+#ifndef CPU_TOPOLOGY_H
+#define CPU_TOPOLOGY_H
+
+// CPU topology from /sys/devices/system/cpu, for placing threads. Only the CPUs the process may run on
+// (sched_getaffinity, so taskset and cgroup limits are kept) are listed, each with its package (socket),
+// core and NUMA node. cpu_topology_order() sorts them for a placement:
+//   compact - the SMT siblings of a core, then the next core of the package, then the next package, so
+//             threads placed one after the other share as much cache as possible
+//   scatter - one CPU of every package in turn, then of every core, SMT siblings last, so no two threads
+//             share a core or a last level cache before they have to
+// A file that is missing (containers, some architectures) counts as package 0, its own core and node 0.
+// Needs _GNU_SOURCE for cpu_set_t.
+
+#include <dirent.h> // DIR, struct dirent, opendir, readdir, closedir
+#include <sched.h> // cpu_set_t, CPU_SETSIZE, CPU_ZERO, CPU_SET, CPU_ISSET, CPU_COUNT, sched_getaffinity
+#include <stdio.h> // FILE, fopen, fscanf, fclose, snprintf, fprintf, stderr
+#include <stdlib.h> // EXIT_FAILURE, exit, malloc, free, qsort, strtol
+
+#define CPU_TOPOLOGY_COMPACT	0
+#define CPU_TOPOLOGY_SCATTER	1
+
+// Define printing strings
+#define CPU_TOPOLOGY_ERROR_MALLOC_MSG	"[Error] Failed to allocate memory to the CPU topology.\n"
+
+typedef struct cpu_topology_cpu {
+	int cpu;
+	int package;
+	int core; // core_id, only unique within its package
+	int node; // Dense index, the n-th node that has CPUs of this process
+	int smt; // Rank among the CPUs of its core, 0 for the first hyperthread
+	int core_rank; // Rank of its core within the package
+} cpu_topology_cpu_t;
+typedef struct cpu_topology {
+	int count;
+	int nodes;
+	cpu_topology_cpu_t *cpus; // By CPU number
+} cpu_topology_t;
+
+static inline int cpu_topology_read(int cpu, const char *name, int dflt) {
+	char path[128];
+	FILE *file;
+	int value;
+	snprintf(path,sizeof(path),"/sys/devices/system/cpu/cpu%d/topology/%s",cpu,name);
+	if ((file = fopen(path,"r")) == NULL) {
+		return dflt;
+	}
+	if ((fscanf(file,"%d",&value) != 1)||(value < 0)) { // physical_package_id is -1 where the firmware does not tell
+		value = dflt;
+	}
+	fclose(file);
+	return value;
+}
+// cpu_topology_node_id - the N of the 'nodeN' link in the CPU's directory, 0 without NUMA support
+static inline int cpu_topology_node_id(int cpu) {
+	char path[64];
+	DIR *dir;
+	struct dirent *entry;
+	int node = 0;
+	snprintf(path,sizeof(path),"/sys/devices/system/cpu/cpu%d",cpu);
+	if ((dir = opendir(path)) == NULL) {
+		return 0;
+	}
+	while ((entry = readdir(dir)) != NULL) {
+		if ((entry->d_name[0] == 'n')&&(entry->d_name[1] == 'o')&&(entry->d_name[2] == 'd')&&(entry->d_name[3] == 'e')&&('0' <= entry->d_name[4])&&(entry->d_name[4] <= '9')) {
+			node = (int)strtol(entry->d_name+4,NULL,10);
+			break;
+		}
+	}
+	closedir(dir);
+	return node;
+}
+// cpu_topology_rank - fill 'smt', 'core_rank' and the dense 'node' from cpu, package, core and the node ids
+static inline void cpu_topology_rank(cpu_topology_t *topo) {
+	cpu_topology_cpu_t *c = topo->cpus;
+	int i;
+	int j;
+	int first;
+	int node_ids[CPU_SETSIZE];
+	topo->nodes = 0;
+	for (i = 0; i < topo->count; i++) {
+		c[i].smt = 0;
+		first = i; // Lowest numbered CPU of the same core
+		for (j = 0; j < i; j++) {
+			if ((c[j].package == c[i].package)&&(c[j].core == c[i].core)) {
+				c[i].smt += 1;
+				if (c[i].smt == 1) {
+					first = j;
+				}
+			}
+		}
+		if (first != i) {
+			c[i].core_rank = c[first].core_rank;
+		} else {
+			c[i].core_rank = 0;
+			for (j = 0; j < i; j++) {
+				if ((c[j].package == c[i].package)&&(c[j].smt == 0)) {
+					c[i].core_rank += 1;
+				}
+			}
+		}
+		for (j = 0; (j < topo->nodes)&&(node_ids[j] != c[i].node); j++) {
+		}
+		if (j == topo->nodes) {
+			node_ids[topo->nodes++] = c[i].node;
+		}
+		c[i].node = j;
+	}
+}
+static inline void cpu_topology_load(cpu_topology_t *topo) {
+	cpu_set_t allowed;
+	int cpu;
+	int i = 0;
+	if (sched_getaffinity(0,sizeof(cpu_set_t),&allowed) != 0) { // On success, sched_getaffinity() ... return 0. On failure, they return -1 and set errno to indicate the error.
+		CPU_ZERO(&allowed);
+		CPU_SET(0,&allowed);
+	}
+	topo->count = CPU_COUNT(&allowed);
+	if ((topo->cpus = (cpu_topology_cpu_t *)malloc(topo->count*sizeof(cpu_topology_cpu_t))) == NULL) { // The malloc() function return a pointer to the allocated memory that is suitably aligned for any kind of variable. On error, these functions return NULL.
+		fprintf(stderr,CPU_TOPOLOGY_ERROR_MALLOC_MSG);
+		exit(EXIT_FAILURE);
+	}
+	for (cpu = 0; (cpu < CPU_SETSIZE)&&(i < topo->count); cpu++) {
+		if (CPU_ISSET(cpu,&allowed)) {
+			topo->cpus[i].cpu = cpu;
+			topo->cpus[i].package = cpu_topology_read(cpu,"physical_package_id",0);
+			topo->cpus[i].core = cpu_topology_read(cpu,"core_id",cpu);
+			topo->cpus[i].node = cpu_topology_node_id(cpu);
+			i += 1;
+		}
+	}
+	cpu_topology_rank(topo);
+}
+static inline int cpu_topology_cmp_compact(const void *a, const void *b) {
+	const cpu_topology_cpu_t *ca = a;
+	const cpu_topology_cpu_t *cb = b;
+	if (ca->package != cb->package) {
+		return (ca->package < cb->package) ? -1 : 1;
+	}
+	if (ca->core_rank != cb->core_rank) {
+		return (ca->core_rank < cb->core_rank) ? -1 : 1;
+	}
+	return (ca->smt > cb->smt) - (ca->smt < cb->smt);
+}
+static inline int cpu_topology_cmp_scatter(const void *a, const void *b) {
+	const cpu_topology_cpu_t *ca = a;
+	const cpu_topology_cpu_t *cb = b;
+	if (ca->smt != cb->smt) {
+		return (ca->smt < cb->smt) ? -1 : 1;
+	}
+	if (ca->core_rank != cb->core_rank) {
+		return (ca->core_rank < cb->core_rank) ? -1 : 1;
+	}
+	return (ca->package > cb->package) - (ca->package < cb->package);
+}
+// cpu_topology_order - the CPU numbers in 'order' (CPU_TOPOLOGY_*), 'out' has room for topo->count of them
+static inline void cpu_topology_order(const cpu_topology_t *topo, int order, int *out) {
+	cpu_topology_cpu_t sorted[topo->count];
+	int i;
+	for (i = 0; i < topo->count; i++) {
+		sorted[i] = topo->cpus[i];
+	}
+	qsort(sorted,topo->count,sizeof(cpu_topology_cpu_t),(order == CPU_TOPOLOGY_SCATTER) ? cpu_topology_cmp_scatter : cpu_topology_cmp_compact);
+	for (i = 0; i < topo->count; i++) {
+		out[i] = sorted[i].cpu;
+	}
+}
+// cpu_topology_node_set - every CPU of node 'node' (dense index, see cpu_topology_cpu_t)
+static inline void cpu_topology_node_set(const cpu_topology_t *topo, int node, cpu_set_t *set) {
+	int i;
+	CPU_ZERO(set);
+	for (i = 0; i < topo->count; i++) {
+		if (topo->cpus[i].node == node) {
+			CPU_SET(topo->cpus[i].cpu,set);
+		}
+	}
+}
+static inline void cpu_topology_destroy(cpu_topology_t *topo) {
+	free(topo->cpus);
+	topo->cpus = NULL;
+	topo->count = 0;
+	topo->nodes = 0;
+}
+
+#endif
@@ -0,0 +1,183 @@
+#ifndef EPOCH_H
+#define EPOCH_H
+
+// Epoch based reclamation (Fraser, 2004) for observers that read a structure without its lock, the intlist
+// snapshots. Only the observers announce themselves, between epoch_enter() and epoch_leave(). The threads that
+// unlink memory hand it to epoch_retire() instead of freeing it: while no observer is inside, that frees it at
+// once, otherwise it waits in the thread's record until the global epoch moved on twice. The epoch only moves
+// when every observer inside entered in the current one, so by then each one that might have seen it has left.
+// The observers pay for the ordering, not the threads that free: with membarrier() (Linux 4.14) epoch_enter()
+// makes every other thread of the process execute a full barrier, and the fast path of epoch_retire() is a
+// plain load. Without it epoch_retire() issues the fence itself.
+// While 'epoch_enabled' is 0, epoch_retire() calls the free function directly. epoch_init() sets it, before the
+// threads start. Every thread owns one record, given back when it exits (with what it could not free yet).
+// epoch_drain() frees everything that is still retired, only when no other thread uses the domain.
+
+#include <limits.h> // LONG_MAX
+#include <linux/membarrier.h> // MEMBARRIER_CMD_REGISTER_PRIVATE_EXPEDITED, MEMBARRIER_CMD_PRIVATE_EXPEDITED
+#include <pthread.h> // pthread_once_t, pthread_key_t, pthread_once, pthread_key_create, pthread_setspecific
+#include <stdio.h> // fprintf, stderr
+#include <stdlib.h> // EXIT_FAILURE, exit, malloc, realloc
+#include <sys/syscall.h> // SYS_membarrier
+#include <unistd.h> // syscall
+
+#define EPOCH_SCAN	64 // A thread tries to advance the epoch, and frees what it can, every this many retirements
+
+// Define printing strings
+#define EPOCH_ERROR_MALLOC_MSG	"[Error] Failed to allocate memory to epoch reclamation.\n"
+
+typedef void (*epoch_free_t)(void *ptr);
+typedef struct epoch_retired {
+	void *ptr;
+	epoch_free_t free_fn;
+	long epoch; // The global epoch when it was retired, it is freed at epoch+2
+} epoch_retired_t;
+typedef struct epoch_record {
+	long epoch; // The global epoch its observer entered in
+	int inside; // 1 between epoch_enter() and epoch_leave()
+	int active; // 1 while a thread owns the record
+	int retired_count;
+	int retired_size;
+	epoch_retired_t *retired; // Unlinked memory an observer may still be reading
+	struct epoch_record *next; // Records are only added, never removed
+} epoch_record_t;
+
+static int epoch_enabled = 0;
+static int epoch_membarrier = 0; // 1 if epoch_enter() can order the other threads with membarrier()
+static long epoch_global = 0;
+static int epoch_observers = 0; // Threads between epoch_enter() and epoch_leave()
+static epoch_record_t *epoch_records = NULL;
+static __thread epoch_record_t *epoch_self = NULL;
+static pthread_key_t epoch_key; // Its destructor gives the record back when the thread exits
+static pthread_once_t epoch_key_once = PTHREAD_ONCE_INIT;
+
+static inline void epoch_release(void *ptr) {
+	epoch_record_t *rec = ptr;
+	__atomic_store_n(&rec->inside,0,__ATOMIC_RELEASE);
+	__atomic_store_n(&rec->active,0,__ATOMIC_RELEASE);
+}
+static inline void epoch_key_create(void) {
+	pthread_key_create(&epoch_key,epoch_release);
+}
+static inline epoch_record_t *epoch_acquire(void) {
+	epoch_record_t *rec;
+	int expected;
+	if (epoch_self != NULL) {
+		return epoch_self;
+	}
+	pthread_once(&epoch_key_once,epoch_key_create);
+	for (rec = __atomic_load_n(&epoch_records,__ATOMIC_ACQUIRE); rec != NULL; rec = rec->next) { // Reuse the record of a thread that exited
+		expected = 0;
+		if ((__atomic_load_n(&rec->active,__ATOMIC_RELAXED) == 0)&&(__atomic_compare_exchange_n(&rec->active,&expected,1,0,__ATOMIC_ACQUIRE,__ATOMIC_RELAXED))) {
+			break;
+		}
+	}
+	if (rec == NULL) {
+		if ((rec = (epoch_record_t *)malloc(sizeof(epoch_record_t))) == NULL) { // The malloc() function return a pointer to the allocated memory that is suitably aligned for any kind of variable. On error, these functions return NULL.
+			fprintf(stderr,EPOCH_ERROR_MALLOC_MSG);
+			exit(EXIT_FAILURE);
+		}
+		rec->epoch = 0;
+		rec->inside = 0;
+		rec->active = 1;
+		rec->retired_count = 0;
+		rec->retired_size = 0;
+		rec->retired = NULL;
+		rec->next = __atomic_load_n(&epoch_records,__ATOMIC_RELAXED);
+		while (!__atomic_compare_exchange_n(&epoch_records,&rec->next,rec,1,__ATOMIC_RELEASE,__ATOMIC_RELAXED)) {
+		}
+	}
+	pthread_setspecific(epoch_key,rec);
+	epoch_self = rec;
+	return rec;
+}
+static inline void epoch_init(void) {
+	epoch_enabled = 1;
+	epoch_membarrier = (syscall(SYS_membarrier,MEMBARRIER_CMD_REGISTER_PRIVATE_EXPEDITED,0) == 0); // On success, the MEMBARRIER_CMD_REGISTER_PRIVATE_EXPEDITED operation returns zero. On error, -1 is returned, and errno is set appropriately.
+}
+// epoch_enter - from here on until epoch_leave(), nothing the caller can reach is freed
+static inline void epoch_enter(void) {
+	epoch_record_t *rec = epoch_acquire();
+	__atomic_add_fetch(&epoch_observers,1,__ATOMIC_SEQ_CST);
+	__atomic_store_n(&rec->epoch,__atomic_load_n(&epoch_global,__ATOMIC_SEQ_CST),__ATOMIC_SEQ_CST);
+	__atomic_store_n(&rec->inside,1,__ATOMIC_SEQ_CST);
+	if (epoch_membarrier) { // Now a thread that unlinked something either sees 'epoch_observers' or we see its unlink
+		syscall(SYS_membarrier,MEMBARRIER_CMD_PRIVATE_EXPEDITED,0);
+	}
+}
+static inline void epoch_leave(void) {
+	epoch_record_t *rec = epoch_acquire();
+	__atomic_store_n(&rec->inside,0,__ATOMIC_RELEASE);
+	__atomic_sub_fetch(&epoch_observers,1,__ATOMIC_RELEASE);
+}
+// epoch_advance - move the global epoch on if every observer inside entered in the current one
+static inline void epoch_advance(void) {
+	epoch_record_t *rec;
+	long epoch = __atomic_load_n(&epoch_global,__ATOMIC_SEQ_CST);
+	for (rec = __atomic_load_n(&epoch_records,__ATOMIC_ACQUIRE); rec != NULL; rec = rec->next) {
+		if ((__atomic_load_n(&rec->inside,__ATOMIC_SEQ_CST))&&(__atomic_load_n(&rec->epoch,__ATOMIC_SEQ_CST) != epoch)) {
+			return;
+		}
+	}
+	__atomic_compare_exchange_n(&epoch_global,&epoch,epoch+1,0,__ATOMIC_SEQ_CST,__ATOMIC_RELAXED); // May fail if another thread advanced
+}
+// epoch_collect - free the retired memory of 'rec' from before 'safe' (all of it if 'safe' is LONG_MAX)
+static inline void epoch_collect(epoch_record_t *rec, long safe) {
+	int i;
+	int kept = 0;
+	for (i = 0; i < rec->retired_count; i++) {
+		if (rec->retired[i].epoch < safe) {
+			rec->retired[i].free_fn(rec->retired[i].ptr);
+		} else {
+			rec->retired[kept++] = rec->retired[i];
+		}
+	}
+	rec->retired_count = kept;
+}
+static inline void epoch_retire_slow(void *ptr, epoch_free_t free_fn) {
+	epoch_record_t *rec = epoch_acquire();
+	if (rec->retired_count == rec->retired_size) {
+		rec->retired_size = (rec->retired_size == 0) ? EPOCH_SCAN : 2*rec->retired_size;
+		if ((rec->retired = (epoch_retired_t *)realloc(rec->retired,rec->retired_size*sizeof(epoch_retired_t))) == NULL) { // The realloc() function returns a pointer to the newly allocated memory ... If realloc() fails, the original block is left untouched
+			fprintf(stderr,EPOCH_ERROR_MALLOC_MSG);
+			exit(EXIT_FAILURE);
+		}
+	}
+	rec->retired[rec->retired_count].ptr = ptr;
+	rec->retired[rec->retired_count].free_fn = free_fn;
+	rec->retired[rec->retired_count].epoch = __atomic_load_n(&epoch_global,__ATOMIC_SEQ_CST);
+	rec->retired_count += 1;
+	if (rec->retired_count % EPOCH_SCAN == 0) {
+		epoch_advance();
+		epoch_collect(rec,__atomic_load_n(&epoch_global,__ATOMIC_SEQ_CST)-1);
+	}
+}
+// epoch_retire - 'ptr' was unlinked from the shared structure, free it with 'free_fn' once no observer can reach it
+static inline void epoch_retire(void *ptr, epoch_free_t free_fn) {
+	if (!epoch_enabled) {
+		free_fn(ptr);
+		return;
+	}
+	if (epoch_membarrier) { // The unlink must not move below the load, epoch_enter() fences for us
+		__atomic_signal_fence(__ATOMIC_SEQ_CST);
+	} else {
+		__atomic_thread_fence(__ATOMIC_SEQ_CST);
+	}
+	if (__atomic_load_n(&epoch_observers,__ATOMIC_ACQUIRE) != 0) {
+		epoch_retire_slow(ptr,free_fn);
+		return;
+	}
+	if ((epoch_self != NULL)&&(0 < epoch_self->retired_count)) { // Every observer that could see them has left, and new ones cannot
+		epoch_collect(epoch_self,LONG_MAX);
+	}
+	free_fn(ptr);
+}
+// epoch_drain - free the retired memory of every record. Only when no other thread uses the domain.
+static inline void epoch_drain(void) {
+	epoch_record_t *rec;
+	for (rec = epoch_records; rec != NULL; rec = rec->next) {
+		epoch_collect(rec,LONG_MAX);
+	}
+}
+
+#endif
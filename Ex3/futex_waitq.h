@@ -0,0 +1,54 @@
+#ifndef FUTEX_WAITQ_H
+#define FUTEX_WAITQ_H
+
+// Parking spot for threads that wait on a structure without a mutex (and so without a condition variable).
+// A waiter announces itself with futex_waitq_prepare(), re-checks its condition, and only then sleeps in
+// futex_waitq_wait(). A waker changes the shared state first and then calls futex_waitq_wake(), which is a
+// single atomic load while nobody waits. Every wakeup bumps 'seq', so a waiter that read 'seq' before the
+// change does not sleep (FUTEX_WAIT returns EAGAIN) and no wakeup is lost.
+
+#include <stddef.h> // NULL
+#include <time.h> // struct timespec
+#include <unistd.h> // syscall
+#include <sys/syscall.h> // SYS_futex
+#include <linux/futex.h> // FUTEX_WAIT_PRIVATE, FUTEX_WAKE_PRIVATE
+
+typedef struct futex_waitq {
+	int seq; // The futex word, bumped by every wakeup
+	int waiters; // Threads between futex_waitq_prepare() and the end of futex_waitq_wait() / futex_waitq_cancel()
+} futex_waitq_t;
+
+static inline void futex_waitq_init(futex_waitq_t *wq) {
+	wq->seq = 0;
+	wq->waiters = 0;
+}
+// futex_waitq_prepare - announce a waiter and return the ticket for futex_waitq_wait(). The caller must
+// re-check its condition after this call, and call futex_waitq_cancel() if it does not need to sleep.
+static inline int futex_waitq_prepare(futex_waitq_t *wq) {
+	int seq = __atomic_load_n(&wq->seq,__ATOMIC_SEQ_CST);
+	__atomic_add_fetch(&wq->waiters,1,__ATOMIC_SEQ_CST);
+	return seq;
+}
+static inline void futex_waitq_cancel(futex_waitq_t *wq) {
+	__atomic_sub_fetch(&wq->waiters,1,__ATOMIC_SEQ_CST);
+}
+// futex_waitq_wait - sleep until a wakeup that happened after futex_waitq_prepare(). May return early
+// (EINTR, spurious wakeup), callers re-check their condition in a loop.
+static inline void futex_waitq_wait(futex_waitq_t *wq, int seq) {
+	syscall(SYS_futex,&wq->seq,FUTEX_WAIT_PRIVATE,seq,NULL,NULL,0); // Returns 0 when woken, -1 with EAGAIN if 'seq' already moved or EINTR
+	__atomic_sub_fetch(&wq->waiters,1,__ATOMIC_SEQ_CST);
+}
+// futex_waitq_wait_timeout - like futex_waitq_wait(), but returns after 'timeout' (relative) at the latest.
+static inline void futex_waitq_wait_timeout(futex_waitq_t *wq, int seq, const struct timespec *timeout) {
+	syscall(SYS_futex,&wq->seq,FUTEX_WAIT_PRIVATE,seq,timeout,NULL,0); // -1 with ETIMEDOUT once 'timeout' expired
+	__atomic_sub_fetch(&wq->waiters,1,__ATOMIC_SEQ_CST);
+}
+// futex_waitq_wake - wake up to 'count' waiters. Must be called after the state they wait for was published.
+static inline void futex_waitq_wake(futex_waitq_t *wq, int count) {
+	if (0 < __atomic_load_n(&wq->waiters,__ATOMIC_SEQ_CST)) {
+		__atomic_add_fetch(&wq->seq,1,__ATOMIC_SEQ_CST);
+		syscall(SYS_futex,&wq->seq,FUTEX_WAKE_PRIVATE,count,NULL,NULL,0);
+	}
+}
+
+#endif
@@ -0,0 +1,176 @@
+#ifndef HAZARD_PTR_H
+#define HAZARD_PTR_H
+
+// Hazard pointers (Michael, 2004) - safe memory reclamation for the lock-free intlist backend.
+// Before a thread dereferences a shared node it publishes the node's address in one of its hazard slots and
+// re-reads the source to make sure the node was not removed in between. A removed node is not freed at once
+// but retired: it is freed by a later scan, once no hazard slot of any thread points to it.
+// Every thread owns one record, taken on its first use and given back when the thread exits (the retired
+// nodes it could not free yet go with the record to the next owner). hazard_drain() frees everything that is
+// still retired, it may only be called when no other thread uses the domain.
+
+#include <pthread.h> // pthread_once_t, pthread_key_t, pthread_once, pthread_key_create, pthread_setspecific
+#include <stdio.h> // fprintf, stderr
+#include <stdlib.h> // EXIT_FAILURE, exit, malloc, realloc, free, qsort, bsearch
+
+#define HAZARD_SLOTS		2 // Hazard pointers per thread, the Michael-Scott queue needs two
+#define HAZARD_SCAN_MIN		64 // Scan once this many nodes are retired (more with many threads, see hazard_retire)
+
+// Define printing strings
+#define HAZARD_ERROR_MALLOC_MSG	"[Error] Failed to allocate memory to hazard pointers.\n"
+
+typedef void (*hazard_free_t)(void *ptr);
+typedef struct hazard_retired {
+	void *ptr;
+	hazard_free_t free_fn;
+} hazard_retired_t;
+typedef struct hazard_record {
+	void *slots[HAZARD_SLOTS]; // Nodes this thread may dereference right now
+	int active; // 1 while a thread owns the record
+	int retired_count;
+	int retired_size;
+	hazard_retired_t *retired; // Removed nodes that may still be in use by other threads
+	int snapshot_size;
+	void **snapshot; // Scratch for hazard_scan(), the sorted hazard slots of every record
+	struct hazard_record *next; // Records are only added, never removed
+} hazard_record_t;
+
+static hazard_record_t *hazard_records = NULL;
+static int hazard_records_count = 0;
+static __thread hazard_record_t *hazard_self = NULL;
+static pthread_key_t hazard_key; // Its destructor gives the record back when the thread exits
+static pthread_once_t hazard_key_once = PTHREAD_ONCE_INIT;
+
+static inline void hazard_release(void *ptr) {
+	hazard_record_t *rec = ptr;
+	int i;
+	for (i = 0; i < HAZARD_SLOTS; i++) {
+		__atomic_store_n(&rec->slots[i],NULL,__ATOMIC_RELEASE);
+	}
+	__atomic_store_n(&rec->active,0,__ATOMIC_RELEASE);
+}
+static inline void hazard_key_create(void) {
+	pthread_key_create(&hazard_key,hazard_release);
+}
+static inline hazard_record_t *hazard_acquire(void) {
+	hazard_record_t *rec;
+	int expected;
+	int i;
+	if (hazard_self != NULL) {
+		return hazard_self;
+	}
+	pthread_once(&hazard_key_once,hazard_key_create);
+	for (rec = __atomic_load_n(&hazard_records,__ATOMIC_ACQUIRE); rec != NULL; rec = rec->next) { // Reuse the record of a thread that exited
+		expected = 0;
+		if ((__atomic_load_n(&rec->active,__ATOMIC_RELAXED) == 0)&&(__atomic_compare_exchange_n(&rec->active,&expected,1,0,__ATOMIC_ACQUIRE,__ATOMIC_RELAXED))) {
+			break;
+		}
+	}
+	if (rec == NULL) {
+		if ((rec = (hazard_record_t *)malloc(sizeof(hazard_record_t))) == NULL) { // The malloc() function return a pointer to the allocated memory that is suitably aligned for any kind of variable. On error, these functions return NULL.
+			fprintf(stderr,HAZARD_ERROR_MALLOC_MSG);
+			exit(EXIT_FAILURE);
+		}
+		for (i = 0; i < HAZARD_SLOTS; i++) {
+			rec->slots[i] = NULL;
+		}
+		rec->active = 1;
+		rec->retired_count = 0;
+		rec->retired_size = 0;
+		rec->retired = NULL;
+		rec->snapshot_size = 0;
+		rec->snapshot = NULL;
+		rec->next = __atomic_load_n(&hazard_records,__ATOMIC_RELAXED);
+		while (!__atomic_compare_exchange_n(&hazard_records,&rec->next,rec,1,__ATOMIC_RELEASE,__ATOMIC_RELAXED)) {
+		}
+		__atomic_add_fetch(&hazard_records_count,1,__ATOMIC_RELAXED);
+	}
+	pthread_setspecific(hazard_key,rec);
+	hazard_self = rec;
+	return rec;
+}
+// hazard_protect - publish the node '*src' points to in 'slot' and return it. The node cannot be freed until the slot is cleared.
+static inline void *hazard_protect(int slot, void **src) {
+	hazard_record_t *rec = hazard_acquire();
+	void *ptr;
+	do {
+		ptr = __atomic_load_n(src,__ATOMIC_SEQ_CST);
+		__atomic_store_n(&rec->slots[slot],ptr,__ATOMIC_SEQ_CST); // Must be visible before the re-read below
+	} while (ptr != __atomic_load_n(src,__ATOMIC_SEQ_CST));
+	return ptr;
+}
+// hazard_set - publish 'ptr' without validation, the caller validates it itself
+static inline void hazard_set(int slot, void *ptr) {
+	__atomic_store_n(&hazard_acquire()->slots[slot],ptr,__ATOMIC_SEQ_CST);
+}
+static inline void hazard_clear(int slot) {
+	__atomic_store_n(&hazard_acquire()->slots[slot],NULL,__ATOMIC_RELEASE);
+}
+static inline int hazard_ptr_cmp(const void *a, const void *b) {
+	const char *pa = *(void * const *)a;
+	const char *pb = *(void * const *)b;
+	return (pa > pb) - (pa < pb);
+}
+// hazard_scan - free the retired nodes of 'rec' that no slot protects. The slots are copied and sorted once,
+// so a scan costs O((R + H) log H) for R retired nodes and H slots instead of O(R * H).
+static inline void hazard_scan(hazard_record_t *rec) {
+	hazard_record_t *other;
+	int count = 0;
+	int i;
+	int kept = 0;
+	void *ptr;
+	for (other = __atomic_load_n(&hazard_records,__ATOMIC_ACQUIRE); other != NULL; other = other->next) {
+		if (rec->snapshot_size < count+HAZARD_SLOTS) { // Every slot must be seen, a missed one could free a node in use
+			rec->snapshot_size = (rec->snapshot_size == 0) ? HAZARD_SCAN_MIN : 2*rec->snapshot_size;
+			if ((rec->snapshot = (void **)realloc(rec->snapshot,rec->snapshot_size*sizeof(void *))) == NULL) { // The realloc() function returns a pointer to the newly allocated memory ... If realloc() fails, the original block is left untouched
+				fprintf(stderr,HAZARD_ERROR_MALLOC_MSG);
+				exit(EXIT_FAILURE);
+			}
+		}
+		for (i = 0; i < HAZARD_SLOTS; i++) {
+			if ((ptr = __atomic_load_n(&other->slots[i],__ATOMIC_SEQ_CST)) != NULL) {
+				rec->snapshot[count++] = ptr;
+			}
+		}
+	}
+	qsort(rec->snapshot,count,sizeof(void *),hazard_ptr_cmp);
+	for (i = 0; i < rec->retired_count; i++) {
+		if (bsearch(&rec->retired[i].ptr,rec->snapshot,count,sizeof(void *),hazard_ptr_cmp) != NULL) {
+			rec->retired[kept++] = rec->retired[i];
+		} else {
+			rec->retired[i].free_fn(rec->retired[i].ptr);
+		}
+	}
+	rec->retired_count = kept;
+}
+// hazard_retire - 'ptr' was unlinked from the shared structure, free it with 'free_fn' once no thread protects it
+static inline void hazard_retire(void *ptr, hazard_free_t free_fn) {
+	hazard_record_t *rec = hazard_acquire();
+	int threshold = 2*HAZARD_SLOTS*__atomic_load_n(&hazard_records_count,__ATOMIC_RELAXED); // At least half of a scan is freed
+	if (rec->retired_count == rec->retired_size) {
+		rec->retired_size = (rec->retired_size == 0) ? HAZARD_SCAN_MIN : 2*rec->retired_size;
+		if ((rec->retired = (hazard_retired_t *)realloc(rec->retired,rec->retired_size*sizeof(hazard_retired_t))) == NULL) { // The realloc() function returns a pointer to the newly allocated memory ... If realloc() fails, the original block is left untouched
+			fprintf(stderr,HAZARD_ERROR_MALLOC_MSG);
+			exit(EXIT_FAILURE);
+		}
+	}
+	rec->retired[rec->retired_count].ptr = ptr;
+	rec->retired[rec->retired_count].free_fn = free_fn;
+	rec->retired_count += 1;
+	if ((HAZARD_SCAN_MIN <= rec->retired_count)&&(threshold <= rec->retired_count)) {
+		hazard_scan(rec);
+	}
+}
+// hazard_drain - free every retired node of every record. Only when no other thread uses the domain.
+static inline void hazard_drain(void) {
+	hazard_record_t *rec;
+	int i;
+	for (rec = hazard_records; rec != NULL; rec = rec->next) {
+		for (i = 0; i < rec->retired_count; i++) {
+			rec->retired[i].free_fn(rec->retired[i].ptr);
+		}
+		rec->retired_count = 0;
+	}
+}
+
+#endif
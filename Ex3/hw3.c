@@ -1,546 +1,2637 @@
-//
-//	                           |---------------------|
-//	                           |    intlist_list     |
-//	                           |------|-------|------|
-//	          -<---<---<---<-  | head | count | tail |  ->--->--->--->---
-//	          |                |------|-------|------|                  |  
-//	         \ /                                                       \ /
-//	          *                                                         *
-//	|-------------------|       |-------------------|         |-------------------|
-//	|   intlist_node    |       |   intlist_node    |         |   intlist_node    |
-//	|------|-----|------|       |------|-----|------|         |------|-----|------|
-//	| NULL | val | next |  <->  | prev | val | next |  >...<  | prev | val | NULL |
-//	|------|-----|------|       |------|-----|------|         |------|-----|------|
-//
-#define _GNU_SOURCE
-#include <errno.h>	// ERANGE, errno
-#include <stdio.h>	// printf, fprintf, stderr
-#include <stdlib.h>	// EXIT_FAILURE, srand, rand, exit, mallo, free, strtol
-#include <string.h>	// strlen, strcpy, strerror
-#include <unistd.h>	// sleep
-#include <pthread.h>	// PTHREAD_MUTEX_RECURSIVE, PTHREAD_CREATE_JOINABLE, 
-			// pthread_cond_init, pthread_cond_wait, pthread_cond_signal, pthread_cond_destroy
-			// pthread_mutex_init, pthread_mutex_lock, pthread_mutex_unlock, pthread_mutex_destroy
-			// pthread_attr_init, pthread_attr_setdetachstate, pthread_attr_destroy
-			// pthread_mutexattr_init, pthread_mutexattr_settype, pthread_mutexattr_destroy
-			// pthread_create, pthread_join, pthread_exit
-#include <limits.h>	// LONG_MAX, LONG_MIN
-
-// Define printing strings
-#define LIST_SIZE_MSG			"The size of the list is:%d\n"
-#define USAGE_NUM_LESS_THEN_ONE_MSG	"The input value must be a positive integer\n"
-#define USAGE_OPERANDS_MISSING_MSG	"Missing operands\nUsage: %s <WNUMc> <RNUM> <MAX> <TIME>\nExiting...\n"
-#define USAGE_OPERANDS_SURPLUS_MSG	"Too many operands\nUsage: %s <WNUMc> <RNUM> <MAX> <TIME>\nExiting...\n"
-#define ERROR_EXIT_MSG			"Exiting...\n"
-#define F_ERROR_MALLOC_LIST_MSG		"[Error] Failed to allocate memory to list.\n"
-#define F_ERROR_MALLOC_NODE_MSG		"[Error] Failed to allocate memory to node.\n"
-#define F_ERROR_MALLOC_THREADS_MSG	"[Error] Failed to allocate memory to threads.\n"
-#define F_ERROR_GENERAL_MSG		"[Error] Error in %s: %s\n"
-#define F_ERROR_STRTOL_MSG		"[Error] Strtol failed with error: %s\n"
-// Define data types
-typedef struct intlist_node {
-	int val;
-	struct intlist_node *prev; // Previously node (Double linked list)
-	struct intlist_node *next; // Next node
-} intlist_node_t;
-typedef struct intlist_list {
-	int count; // How many nodes there are in the list
-	struct intlist_node *head; // First node in the list
-	struct intlist_node *tail; // Last node in the list
-	struct intlist_node *nil; // Pointer to the nil object
-	pthread_mutex_t lock;
-	pthread_mutexattr_t attr;
-	pthread_cond_t cond_new_insert;
-} intlist;
-// Define global variables
-int threads_gc_run = 1;
-int threads_writers_run = 1;
-int threads_readers_run = 1;
-int threads_writers_finish = 0;
-int threads_readers_finish = 0;
-int global_writers = 0;
-int global_readers = 0;
-int global_max = 0;
-int global_time = 0;
-pthread_attr_t attr;
-pthread_cond_t count_garbage_collector;
-// Function declaration
-void intlist_init(intlist* list);
-void intlist_destroy(intlist** list);
-void intlist_push_head(intlist* list, int value);
-int intlist_pop_tail(intlist* list);
-void intlist_remove_last_k(intlist* list, int k);
-int intlist_size(intlist* list);
-pthread_mutex_t* intlist_get_mutex(intlist* list);
-
-// Threads
-void *thrd_writers(void *argStruct) {
-	// Writers - writer threads push random integers to the list, in an infinite loop.
-	int rc; // Variable for pthread_mutex_lock & pthread_mutex_unlock & pthread_cond_signal
-	intlist* list = argStruct;
-	// Push new nodes
-	srand(time(NULL));
-	while (threads_writers_run) {
-		intlist_push_head(list, rand());
-		if (intlist_size(list) >= global_max) { // Wakeup the garbage collector
-			if ((rc = pthread_cond_signal(&count_garbage_collector)) != 0) { // If successful, the pthread_cond_signal() function shall return zero; otherwise, an error number shall be returned to indicate the error.
-				fprintf(stderr,F_ERROR_GENERAL_MSG,"pthread_cond_signal()",strerror(rc));
-				exit(EXIT_FAILURE);
-			}
-		}
-	}
-	// Lock
-	if ((rc = pthread_mutex_lock(intlist_get_mutex(list))) != 0) { // If successful, the pthread_mutex_lock() function shall return zero; otherwise, an error number shall be returned to indicate the error.
-		fprintf(stderr,F_ERROR_GENERAL_MSG,"pthread_mutex_lock()",strerror(rc));
-		exit(EXIT_FAILURE);
-	}
-	// Inc counter
-	threads_writers_finish += 1;
-	// Unlock
-	if ((rc = pthread_mutex_unlock(intlist_get_mutex(list))) != 0) { // If successful, the pthread_mutex_unlock() function shall return zero; otherwise, an error number shall be returned to indicate the error.
-		fprintf(stderr,F_ERROR_GENERAL_MSG,"pthread_mutex_unlock()",strerror(rc));
-		exit(EXIT_FAILURE);
-	}
-	// Finish
-	pthread_exit(NULL);
-}
-void *thrd_readers(void *argStruct) {
-	// Readers – reader threads pop integers from the list, in an infinite loop.
-	int rc; // Variable for pthread_mutex_lock & pthread_mutex_unlock
-	intlist* list = argStruct;
-	// Pop nodes
-	while (threads_readers_run) {
-		intlist_pop_tail(list);
-	}
-	// Lock
-	if ((rc = pthread_mutex_lock(intlist_get_mutex(list))) != 0) { // If successful, the pthread_mutex_lock() function shall return zero; otherwise, an error number shall be returned to indicate the error.
-		fprintf(stderr,F_ERROR_GENERAL_MSG,"pthread_mutex_lock()",strerror(rc));
-		exit(EXIT_FAILURE);
-	}
-	// Inc counter
-	threads_readers_finish += 1;
-	// Unlock
-	if ((rc = pthread_mutex_unlock(intlist_get_mutex(list))) != 0) { // If successful, the pthread_mutex_unlock() function shall return zero; otherwise, an error number shall be returned to indicate the error.
-		fprintf(stderr,F_ERROR_GENERAL_MSG,"pthread_mutex_unlock()",strerror(rc));
-		exit(EXIT_FAILURE);
-	}
-	// Finish
-	pthread_exit(NULL);
-}
-void *thrd_garbage_collector(void *argStruct) {
-	// Garbage Collector – the garbage collector waits until the list has more than MAX items. Once it
-	// has, the garbage collector removes half of the elements in the list (from the tail, rounded up).
-	// In addition, the garbage collector prints the number of items removed from the list. Output a
-	// message like the following: "GC – 7 items removed from the list".
-	int rc; // Variable for pthread_mutex_lock & pthread_mutex_unlock & pthread_cond_wait
-	int k_to_remove = 0;
-	intlist* list = argStruct;
-	// Lock
-	if ((rc = pthread_mutex_lock(intlist_get_mutex(list))) != 0) { // If successful, the pthread_mutex_lock() function shall return zero; otherwise, an error number shall be returned to indicate the error.
-		fprintf(stderr,F_ERROR_GENERAL_MSG,"pthread_mutex_lock()",strerror(rc));
-		exit(EXIT_FAILURE);
-	}
-	// Wait & Clean
-	while (threads_gc_run) { // If the list is empty (list->count == 0)
-		// Sleep
-		if ((rc = pthread_cond_wait(&count_garbage_collector, intlist_get_mutex(list))) != 0) { // Upon successful completion, a value of zero shall be returned; otherwise, an error number shall be returned to indicate the error.
-			fprintf(stderr,F_ERROR_GENERAL_MSG,"pthread_cond_wait()",strerror(rc));
-			exit(EXIT_FAILURE);
-		}
-		// Clean
-		if (intlist_size(list) >= global_max) {
-			k_to_remove = (intlist_size(list)+1)/2;
-			intlist_remove_last_k(list,k_to_remove);
-			printf("GC - %d items removed from the list\n",k_to_remove);
-		}
-	}
-	// Unlock
-	if ((rc = pthread_mutex_unlock(intlist_get_mutex(list))) != 0) { // If successful, the pthread_mutex_unlock() function shall return zero; otherwise, an error number shall be returned to indicate the error.
-		fprintf(stderr,F_ERROR_GENERAL_MSG,"pthread_mutex_unlock()",strerror(rc));
-		exit(EXIT_FAILURE);
-	}
-	// Finish
-	pthread_exit(NULL);
-}
-void *thrd_timer() {
-	int rc; // Variable for pthread_cond_signal
-	// 6. Sleep for TIME seconds.
-	sleep(global_time);
-	// 7. Stop all running threads (safely, avoid deadlocks!)
-	threads_readers_run = 0; // Stop readers threads
-	while (threads_readers_finish < global_readers) { // Wait untill all pthreads die gracefully
-		sleep(1);
-	}
-	threads_writers_run = 0; // Stop writers threads
-	while (threads_writers_finish < global_writers) { // Wait untill all pthreads die gracefully
-		sleep(1);
-	}
-	threads_gc_run = 0; // Stop Garbage Collector thread
-	if ((rc = pthread_cond_signal(&count_garbage_collector)) != 0) { // If successful, the pthread_cond_signal() function shall return zero; otherwise, an error number shall be returned to indicate the error.
-		fprintf(stderr,F_ERROR_GENERAL_MSG,"pthread_cond_signal()",strerror(rc));
-		exit(EXIT_FAILURE);
-	}
-	// Finish
-	pthread_exit(NULL);
-}
-// Functions
-int program_end(int error, intlist* list, pthread_t* threads_writers, pthread_t* threads_readers) {
-	int res = 0;
-	int rc = 0;
-	if (threads_writers) {
-		free(threads_writers);
-		threads_writers = NULL;
-	}
-	if (threads_readers) {
-		free(threads_readers);
-		threads_readers = NULL;
-	}
-	if (list) {
-		intlist_destroy(&list);
-	}
-	if ((rc = pthread_cond_destroy(&count_garbage_collector)) != 0) { // If successful, the pthread_cond_destroy() function shall return zero; otherwise, an error number shall be returned to indicate the error.
-		fprintf(stderr,F_ERROR_GENERAL_MSG,"pthread_cond_destroy()",strerror(rc));
-		res = -1;
-	}
-	if ((rc = pthread_attr_destroy(&attr)) != 0) { // On success, these functions return 0; on error, they return a nonzero error number.
-		fprintf(stderr,F_ERROR_GENERAL_MSG,"pthread_attr_destroy()",strerror(rc));
-		res = -1;
-	}
-	if ((error == -1)||(res == -1)) {
-		fprintf(stderr,ERROR_EXIT_MSG);
-	}
-	return res;
-}
-void intlist_init(intlist* list) { // init - initialize the list. You may assume the argument is not a previously initialized or destroyed list.
-	// You may assume init() and destroy() are called once for each list and not concurrently with any other
-	// calls for that list, i.e., these methods do not need to be thread-safe.
-	if (list == NULL) {
-		return;
-	}
-	// Init variables
-	int rc; // Variable for pthread_mutex_init & pthread_cond_init
-	intlist_node_t* nil;
-	// Memory allocation
-	if ((nil = (intlist_node_t *)malloc(sizeof(intlist_node_t))) == NULL) { // The malloc() function return a pointer to the allocated memory that is suitably aligned for any kind of variable. On error, these functions return NULL.
-		fprintf(stderr,F_ERROR_MALLOC_NODE_MSG);
-		exit(EXIT_FAILURE);
-	}
-	// Init the nil element
-	nil->val = 2147483647;
-	nil->prev = NULL;
-	nil->next = NULL;
-	// Init the list element
-	if ((rc = pthread_mutexattr_init(&(list->attr))) != 0) { // Upon successful completion, pthread_mutexattr_init() shall return zero; otherwise, an error number shall be returned to indicate the error.
-		fprintf(stderr,F_ERROR_GENERAL_MSG,"pthread_mutexattr_init()",strerror(rc));
-		exit(EXIT_FAILURE);
-	}
-	if ((rc = pthread_mutexattr_settype(&(list->attr),PTHREAD_MUTEX_RECURSIVE)) != 0) { // If successful, the pthread_mutexattr_settype() function shall return zero; otherwise, an error number shall be returned to indicate the error.
-		fprintf(stderr,F_ERROR_GENERAL_MSG,"pthread_mutexattr_settype()",strerror(rc));
-		exit(EXIT_FAILURE);
-	}
-	if ((rc = pthread_mutex_init(&(list->lock), &(list->attr))) != 0) { // If successful, the pthread_mutex_init() function shall return zero; otherwise, an error number shall be returned to indicate the error.
-		fprintf(stderr,F_ERROR_GENERAL_MSG,"pthread_mutex_init()",strerror(rc));
-		exit(EXIT_FAILURE);
-	}
-	if ((rc = pthread_cond_init(&(list->cond_new_insert), NULL)) != 0) { // If successful, the pthread_cond_init() function shall return zero; otherwise, an error number shall be returned to indicate the error.
-		fprintf(stderr,F_ERROR_GENERAL_MSG,"pthread_cond_init()",strerror(rc));
-		exit(EXIT_FAILURE);
-	}
-	list->nil = nil;
-	list->count = 0;
-	list->head = list->nil;
-	list->tail = list->nil;
-}
-void intlist_destroy(intlist** list) { // destroy – frees all memory used by the list, including any of its items.
-	// You may assume init() and destroy() are called once for each list and not concurrently with any other
-	// calls for that list, i.e., these methods do not need to be thread-safe.
-	// Replace to "intlist**" as aproved at: http://moodle.tau.ac.il/mod/forum/discuss.php?d=21815
-	intlist* list_friendly = *list;
-	if ((list_friendly == NULL)||(list_friendly->nil == NULL)) {
-		return;
-	}
-	int rc; // Variable for pthread_mutex_destroy & pthread_cond_destroy
-	if (list_friendly->head != list_friendly->nil) { // If the list is not empty (list->count > 0)
-		intlist_remove_last_k(list_friendly,list_friendly->count); // Remove all items from the list
-	}
-	free(list_friendly->nil);
-	list_friendly->head = NULL;
-	list_friendly->tail = NULL;
-	list_friendly->nil = NULL;
-	// Destroy
-	if ((rc = pthread_mutex_destroy(&(list_friendly->lock))) != 0) { // If successful, the pthread_mutex_destroy() function shall return zero; otherwise, an error number shall be returned to indicate the error.
-		fprintf(stderr,F_ERROR_GENERAL_MSG,"pthread_mutex_destroy()",strerror(rc));
-		exit(EXIT_FAILURE);
-	}
-	if ((rc = pthread_mutexattr_destroy(&(list_friendly->attr))) != 0) { // Upon successful completion, pthread_mutexattr_destroy() shall return zero; otherwise, an error number shall be returned to indicate the error.
-		fprintf(stderr,F_ERROR_GENERAL_MSG,"pthread_mutexattr_destroy()",strerror(rc));
-		exit(EXIT_FAILURE);
-	}
-	if ((rc = pthread_cond_destroy(&(list_friendly->cond_new_insert))) != 0) { // If successful, the pthread_cond_destroy() function shall return zero; otherwise, an error number shall be returned to indicate the error.
-		fprintf(stderr,F_ERROR_GENERAL_MSG,"pthread_cond_destroy()",strerror(rc));
-		exit(EXIT_FAILURE);
-	}
-	free(*list);
-	*list = NULL;
-	list = NULL;
-}
-void intlist_push_head(intlist* list, int value) { // push_head – receives an int, and adds it to the head of the list.
-	if ((list == NULL)||(list->nil == NULL)) {
-		return;
-	}
-	// Init variables
-	int rc; // Variable for pthread_mutex_lock & pthread_mutex_unlock & pthread_cond_signal
-	intlist_node_t* node;
-	// Memory allocation
-	if ((node = (intlist_node_t *)malloc(sizeof(intlist_node_t))) == NULL) { // The malloc() function return a pointer to the allocated memory that is suitably aligned for any kind of variable. On error, these functions return NULL.
-		fprintf(stderr,F_ERROR_MALLOC_NODE_MSG);
-		exit(EXIT_FAILURE);
-	}
-	// Prepare the new node
-	node->val = value;
-	node->prev = list->nil;
-	// Lock
-	if ((rc = pthread_mutex_lock(&(list->lock))) != 0) { // If successful, the pthread_mutex_lock() function shall return zero; otherwise, an error number shall be returned to indicate the error.
-		fprintf(stderr,F_ERROR_GENERAL_MSG,"pthread_mutex_lock()",strerror(rc));
-		exit(EXIT_FAILURE);
-	}
-	// Push to head
-	if (list->head != list->nil) { // If the list is not empty (list->count > 0)
-		node->next = list->head;
-		node->next->prev = node;
-	} else { // First element
-		node->next = list->nil;
-		list->tail = node;
-	}
-	list->head = node;
-	list->count += 1;
-	// Signal if someone is waiting to pop from the tail
-	if ((rc = pthread_cond_signal(&(list->cond_new_insert))) != 0) { // If successful, the pthread_cond_signal() function shall return zero; otherwise, an error number shall be returned to indicate the error.
-		fprintf(stderr,F_ERROR_GENERAL_MSG,"pthread_cond_signal()",strerror(rc));
-		exit(EXIT_FAILURE);
-	}
-	// Unlock
-	if ((rc = pthread_mutex_unlock(&(list->lock))) != 0) { // If successful, the pthread_mutex_unlock() function shall return zero; otherwise, an error number shall be returned to indicate the error.
-		fprintf(stderr,F_ERROR_GENERAL_MSG,"pthread_mutex_unlock()",strerror(rc));
-		exit(EXIT_FAILURE);
-	}
-}
-int intlist_pop_tail(intlist* list) { // pop_tail – removes an item from the tail, and returns its value.
-	// The operation pop_tail() is blocking, i.e., if the list is empty – wait until an item is available, and then pop it.
-	if ((list == NULL)||(list->nil == NULL)) {
-		return -1;
-	}
-	// Init variables
-	int ret = 0;
-	int rc; // Variable for pthread_mutex_lock & pthread_mutex_unlock & pthread_cond_wait
-	// Lock
-	if ((rc = pthread_mutex_lock(&(list->lock))) != 0) { // If successful, the pthread_mutex_lock() function shall return zero; otherwise, an error number shall be returned to indicate the error.
-		fprintf(stderr,F_ERROR_GENERAL_MSG,"pthread_mutex_lock()",strerror(rc));
-		exit(EXIT_FAILURE);
-	}
-	// Wait
-	while (list->head == list->nil) { // If the list is empty (list->count == 0)
-		if ((rc = pthread_cond_wait(&(list->cond_new_insert), &(list->lock))) != 0) { // Upon successful completion, a value of zero shall be returned; otherwise, an error number shall be returned to indicate the error.
-			fprintf(stderr,F_ERROR_GENERAL_MSG,"pthread_cond_wait()",strerror(rc));
-			exit(EXIT_FAILURE);
-		}
-	}
-	// Pop the tail
-	ret = list->tail->val;
-	if (list->head->next == list->nil) { // If there is only one item in the list (list->count == 1)
-		free(list->tail); // Free the old node from the memory
-		list->head = list->nil;
-		list->tail = list->nil;
-	} else { // There is more then one item in the list
-		list->tail = list->tail->prev; // Move the tail pointer
-		free(list->tail->next); // Free the old node from the memory
-		list->tail->next = list->nil; // Delete the link to the old node
-	}
-	list->count -= 1;
-	// Unlock
-	if ((rc = pthread_mutex_unlock(&(list->lock))) != 0) { // If successful, the pthread_mutex_unlock() function shall return zero; otherwise, an error number shall be returned to indicate the error.
-		fprintf(stderr,F_ERROR_GENERAL_MSG,"pthread_mutex_unlock()",strerror(rc));
-		exit(EXIT_FAILURE);
-	}
-	// Return
-	return ret;
-}
-void intlist_remove_last_k(intlist* list, int k) { // remove_last_k – removes k items from the tail, without returning any value.
-	// When remove_last_k() is called with a k larger than the list size, it removes whatever items are in the list and finishes.
-	if ((list == NULL)||(list->nil == NULL)||(k < 0)) { // http://moodle.tau.ac.il/mod/forum/discuss.php?d=22102
-		return;
-	}
-	// Init variables
-	int i = 0;
-	// Remove k items
-	while ((i < k)&&(0 < list->count)) {
-		intlist_pop_tail(list);
-		i += 1;
-	}
-}
-int intlist_size(intlist* list) { // size – returns the number of items currently in the list.
-	if ((list == NULL)||(list->nil == NULL)) {
-		return -1;
-	}
-	return list->count;
-}
-pthread_mutex_t* intlist_get_mutex(intlist* list) { // get_mutex – returns the mutex used by this list.
-	if ((list == NULL)||(list->nil == NULL)) {
-		return NULL;
-	}
-	return &(list->lock);
-}
-int main(int argc, char *argv[]) {
-	// General variable
-	char* endptr_WNUM; // strtol for global_writers
-	char* endptr_RNUM; // strtol for global_readers
-	char* endptr_MAX; // strtol for global_max
-	char* endptr_TIME; // strtol for global_time
-	int i; // tmp loop var
-	int tmpListSize = 0;
-	int rc; // Variable for pthread_create & pthread_cond_init & pthread_cond_destroy
-	int pthread_create_try = 0;
-	intlist* list = NULL;
-	pthread_t threads_support[2];
-	pthread_t* threads_writers;
-	pthread_t* threads_readers;
-	// Check correct call structure
-	if (argc != 5) {
-		if (argc < 5) {
-			printf(USAGE_OPERANDS_MISSING_MSG,argv[0]);
-		} else {
-			printf(USAGE_OPERANDS_SURPLUS_MSG,argv[0]);
-		}
-		return EXIT_FAILURE;
-	}
-	global_writers = strtol(argv[1], &endptr_WNUM, 10); // If an underflow occurs. strtol() returns LONG_MIN. If an overflow occurs, strtol() returns LONG_MAX. In both cases, errno is set to ERANGE.
-	if ((errno == ERANGE && (global_writers == LONG_MAX || global_writers == LONG_MIN)) || (errno != 0 && global_writers == 0)) {
-		fprintf(stderr,F_ERROR_STRTOL_MSG,strerror(errno));
-		return errno;
-	}
-	global_readers = strtol(argv[2], &endptr_RNUM, 10); // If an underflow occurs. strtol() returns LONG_MIN. If an overflow occurs, strtol() returns LONG_MAX. In both cases, errno is set to ERANGE.
-	if ((errno == ERANGE && (global_readers == LONG_MAX || global_readers == LONG_MIN)) || (errno != 0 && global_readers == 0)) {
-		fprintf(stderr,F_ERROR_STRTOL_MSG,strerror(errno));
-		return errno;
-	}
-	global_max = strtol(argv[3], &endptr_MAX, 10); // If an underflow occurs. strtol() returns LONG_MIN. If an overflow occurs, strtol() returns LONG_MAX. In both cases, errno is set to ERANGE.
-	if ((errno == ERANGE && (global_max == LONG_MAX || global_max == LONG_MIN)) || (errno != 0 && global_max == 0)) {
-		fprintf(stderr,F_ERROR_STRTOL_MSG,strerror(errno));
-		return errno;
-	}
-	global_time = strtol(argv[4], &endptr_TIME, 10); // If an underflow occurs. strtol() returns LONG_MIN. If an overflow occurs, strtol() returns LONG_MAX. In both cases, errno is set to ERANGE.
-	if ((errno == ERANGE && (global_time == LONG_MAX || global_time == LONG_MIN)) || (errno != 0 && global_time == 0)) {
-		fprintf(stderr,F_ERROR_STRTOL_MSG,strerror(errno));
-		return errno;
-	}
-	if ( (endptr_WNUM == argv[1])||(endptr_RNUM == argv[2])||(endptr_MAX == argv[3])||(endptr_TIME == argv[4]) ) { // Empty string
-		printf(USAGE_OPERANDS_MISSING_MSG,argv[0]);
-		return EXIT_FAILURE;
-	}
-	if ( (global_writers < 1)||(global_readers < 1)||(global_max < 1)||(global_time < 1) ) { // Not positive
-		printf(USAGE_NUM_LESS_THEN_ONE_MSG);
-		return EXIT_FAILURE;
-	}
-	// Init threads array
-	if ((threads_writers = (pthread_t *)malloc(sizeof(pthread_t)*global_writers)) == NULL) { // The malloc() function return a pointer to the allocated memory that is suitably aligned for any kind of variable. On error, these functions return NULL.
-		fprintf(stderr,F_ERROR_MALLOC_LIST_MSG);
-		return EXIT_FAILURE;
-	}
-	if ((threads_readers = (pthread_t *)malloc(sizeof(pthread_t)*global_readers)) == NULL) { // The malloc() function return a pointer to the allocated memory that is suitably aligned for any kind of variable. On error, these functions return NULL.
-		fprintf(stderr,F_ERROR_MALLOC_THREADS_MSG);
-		return EXIT_FAILURE;
-	}
-	// Init the attr var
-	if ((rc = pthread_attr_init(&attr)) != 0) { // On success, these functions return 0; on error, they return a nonzero error number.
-		fprintf(stderr,F_ERROR_GENERAL_MSG,"pthread_attr_init()",strerror(rc));
-		return program_end(-1,list,threads_writers,threads_readers);
-	}
-	if ((rc = pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_JOINABLE)) != 0) { // On success, pthread_join() returns 0; on error, it returns an error number.
-		fprintf(stderr,F_ERROR_GENERAL_MSG,"pthread_attr_setdetachstate()",strerror(rc));
-		return program_end(-1,list,threads_writers,threads_readers);
-	}
-	// 1. Define and initialize a global doubly-linked list of integers.
-	if ((list = (intlist *)malloc(sizeof(intlist))) == NULL) { // The malloc() function return a pointer to the allocated memory that is suitably aligned for any kind of variable. On error, these functions return NULL.
-		fprintf(stderr,F_ERROR_MALLOC_LIST_MSG);
-		return program_end(-1,list,threads_writers,threads_readers);
-	}
-	intlist_init(list);
-	// 2. Create a condition variable for the garbage collector. (different than the condition variable used internally by the list's pop_tail operation)
-	if ((rc = pthread_cond_init(&count_garbage_collector, NULL)) != 0) { // If successful, the pthread_cond_init() function shall return zero; otherwise, an error number shall be returned to indicate the error.
-		fprintf(stderr,F_ERROR_GENERAL_MSG,"pthread_cond_init()",strerror(rc));
-		return program_end(-1,list,threads_writers,threads_readers);
-	}
-	// 3. Create a thread for the garbage collector.
-	if ((rc = pthread_create(&threads_support[0], &attr, thrd_garbage_collector, list)) != 0) { // On success, pthread_create() returns 0; on error, it returns an error number, and the contents of *thread are undefined.
-		fprintf(stderr,F_ERROR_GENERAL_MSG,"GC pthread_create()",strerror(rc));
-		return program_end(-1,list,threads_writers,threads_readers);
-	}
-	// 4. Create WNUM threads for the writers.
-	for (i=0;i<global_writers;i++) {
-		pthread_create_try = 0;
-		while (pthread_create_try < 2) { // Give it two tries
-			if ((rc = pthread_create(&threads_writers[i], &attr, thrd_writers, list)) != 0) { // On success, pthread_create() returns 0; on error, it returns an error number, and the contents of *thread are undefined.
-				if (pthread_create_try == 0) { // pthread_create failed for the first time
-					pthread_create_try += 1;
-					sleep(1);
-				} else { // pthread_create failed for the second time
-					fprintf(stderr,F_ERROR_GENERAL_MSG,"writers pthread_create()",strerror(rc));
-					return program_end(-1,list,threads_writers,threads_readers);
-				}
-			} else {
-				pthread_create_try = 2;
-			}
-		}
-	}
-	// 5. Create RNUM threads for the readers.
-	for (i=0;i<(int)global_readers;i++) {
-		pthread_create_try = 0;
-		while (pthread_create_try < 2) { // Give it two tries
-			if ((rc = pthread_create(&threads_readers[i], &attr, thrd_readers, list)) != 0) { // On success, pthread_create() returns 0; on error, it returns an error number, and the contents of *thread are undefined.
-				if (pthread_create_try == 0) { // pthread_create failed for the first time
-					pthread_create_try += 1;
-					sleep(1);
-				} else { // pthread_create failed for the second time
-					fprintf(stderr,F_ERROR_GENERAL_MSG,"readers pthread_create()",strerror(rc));
-					return program_end(-1,list,threads_writers,threads_readers);
-				}
-			} else {
-				pthread_create_try = 2;
-			}
-		}
-	}
-	// 6. Sleep for TIME seconds.
-	// 7. Stop all running threads (safely, avoid deadlocks!)
-	if ((rc = pthread_create(&threads_support[1], &attr, thrd_timer, NULL)) != 0) { // On success, pthread_create() returns 0; on error, it returns an error number, and the contents of *thread are undefined.
-		fprintf(stderr,F_ERROR_GENERAL_MSG,"timer pthread_create()",strerror(rc));
-		return program_end(-1,list,threads_writers,threads_readers);
-	}
-	// Join all threads
-	for (i=0;i<2;i++) {
-		if ((rc = pthread_join(threads_support[i], NULL)) != 0) { // On success, pthread_join() returns 0; on error, it returns an error number.
-			fprintf(stderr,F_ERROR_GENERAL_MSG,"pthread_join()",strerror(rc));
-			return program_end(-1,list,threads_writers,threads_readers);
-		}
-	}
-	for (i=0;i<global_writers;i++) {
-		if ((rc = pthread_join(threads_writers[i], NULL)) != 0) { // On success, pthread_join() returns 0; on error, it returns an error number.
-			fprintf(stderr,F_ERROR_GENERAL_MSG,"writers pthread_join()",strerror(rc));
-			return program_end(-1,list,threads_writers,threads_readers);
-		}
-	}
-	for (i=0;i<global_readers;i++) {
-		if ((rc = pthread_join(threads_readers[i], NULL)) != 0) { // On success, pthread_join() returns 0; on error, it returns an error number.
-			fprintf(stderr,F_ERROR_GENERAL_MSG,"readers pthread_join()",strerror(rc));
-			return program_end(-1,list,threads_writers,threads_readers);
-		}
-	}
-	// 8. Print the size of the list as well as all items within it.
-	tmpListSize = intlist_size(list);
-	for (i=0;i<tmpListSize;i++) {
-		printf("%d\n",intlist_pop_tail(list));
-	}
-	printf(LIST_SIZE_MSG,tmpListSize);
-	// 9. Cleanup. Exit gracefully
-	pthread_exit(NULL);
-	return program_end(0,list,threads_writers,threads_readers);
-}
+//
+//	                           |---------------------|
+//	                           |    intlist_list     |
+//	                           |------|-------|------|
+//	          -<---<---<---<-  | head | count | tail |  ->--->--->--->---
+//	          |                |------|-------|------|                  |  
+//	         \ /                                                       \ /
+//	          *                                                         *
+//	|-------------------|       |-------------------|         |-------------------|
+//	|   intlist_node    |       |   intlist_node    |         |   intlist_node    |
+//	|------|-----|------|       |------|-----|------|         |------|-----|------|
+//	| NULL | val | next |  <->  | prev | val | next |  >...<  | prev | val | NULL |
+//	|------|-----|------|       |------|-----|------|         |------|-----|------|
+//
+// Backends ('--backend='):
+//	mutex    - The list above, every operation takes 'lock' (the default)
+//	lockfree - A Michael-Scott queue linked through 'next' from the tail (oldest, a dummy node) to the head
+//	           (newest). push_head and pop_tail are CAS loops, removed nodes are freed through hazard pointers
+//	           (hazard_ptr.h) and an empty pop_tail parks on a futex (futex_waitq.h). 'lock' is only used
+//	           by intlist_close(), intlist_set_capacity() and the callers of intlist_get_mutex().
+//	unrolled - Locked like 'mutex', but every node (segment) holds an array of values, newest first, in
+//	           vals[first..end-1]. push_head fills the head segment towards index 0, pop_tail empties the tail
+//	           segment from its end. A value costs 4 bytes instead of a 24 byte node, a traversal touches one
+//	           cache line per 16 values and remove_last_k unlinks whole segments.
+//	twolock  - The two-lock queue of Michael and Scott: 'tail' is a dummy node whose 'prev' is the oldest item,
+//	           'head' is the newest. Writers take 'head_lock' and readers take 'tail_lock', so they only meet
+//	           on the dummy's 'prev' when the list is empty. 'count' is atomic and an empty pop_tail parks on
+//	           the futex like lockfree.
+//	combining- The mutex list behind flat combining: a thread publishes its push or pop in its own request
+//	           record of the list (fc_request_t), and whoever takes 'lock' serves every published request in
+//	           one pass (fc_combine), while the list stays hot in its cache. The other threads spin on their
+//	           record meanwhile instead of queueing for the lock. A pop of too few items, or a push into a full
+//	           bounded list, is parked on its record's futex until a later pass, or intlist_close, serves it.
+//
+// Sharded mode ('--sharded'): one list (of the chosen backend) per writer, so the writers never share a
+// cache line. A reader pops from its home shard (reader id modulo the shard count) and, when it is empty,
+// steals from the next shards in order, parking on the shard set's futex only when all of them are empty.
+// Each shard stays FIFO: the items one writer pushed are popped in the order it pushed them. There is no
+// order between items of different writers. The garbage collector trims every shard on its own, once it
+// holds its share of MAX (MAX divided by the number of shards, rounded up).
+//
+// Bounded mode ('--bounded'): every list (shard) holds at most its share of MAX. A writer that finds it full
+// waits until readers made room ('cond_not_full' for the lock based backends, the 'waitq_full' futex for the
+// others, where writers reserve 'slots' before they link), with '--bounded=try' it gives up and counts the
+// batch as rejected instead. Nothing is thrown away, so the garbage collector is not triggered.
+//
+// Shutdown: the timer stops the readers first, like shutdown(2) it closes every list for them (intlist_close
+// with INTLIST_SHUT_RD): blocking pops return what is left and then INTLIST_CLOSED, instead of waiting for a
+// push that may never come. Once they are joined it stops the writers, and closes the lists for them too
+// (INTLIST_SHUT_RDWR): new items are refused and a writer waiting for room returns. What the writers pushed
+// in between is what step 8 prints.
+//
+// Waiting readers ('--spin=N'): a reader that finds too few items first spins on 'count' with pause
+// instructions, up to an adaptive budget of at most N (SPIN_MAX by default, 0 on a single CPU), and only
+// then sleeps on 'cond_new_insert' or the futex. Writers signal only when a reader sleeps ('waiters' for
+// the condition variable, the futex_waitq keeps its own count), so under steady load a push makes no syscall.
+//
+// Placement ('--affinity='): by default the threads float. Otherwise every writer, reader and the garbage
+// collector is created with a CPU set (cpu_topology.h):
+//	compact  - one CPU each, in compact order: writers, then readers, then the collector
+//	scatter  - the same in scatter order, every thread on its own core and socket as long as there are enough
+//	paired   - writer i and reader i on neighbouring CPUs of the compact order (SMT siblings of one core if
+//	           the machine has them), so an item crosses at most one cache level. In sharded mode reader i's
+//	           home shard is writer i's list.
+//	numa     - the threads of a shard on every CPU of one NUMA node (shard modulo the nodes), the scheduler
+//	           balances within it. The writers allocate the nodes, so the items stay node-local.
+// Threads beyond the CPUs wrap around. '--bench' with '--affinity=all' runs every policy.
+//
+// Monitoring ('--monitor=MS'): every MS milliseconds a monitor thread walks every list with intlist_snapshot,
+// which takes no lock and never blocks the writers or readers, and prints what it saw to stderr. Removed nodes
+// and segments are then freed through epoch based reclamation (epoch.h), so a snapshot never reads freed
+// memory. Without the option epoch_retire() frees at once and the unrolled backend keeps its spare segment.
+//
+#define _GNU_SOURCE
+#include <errno.h>	// ERANGE, EBUSY, errno
+#include <stdio.h>	// printf, fprintf, stderr
+#include <stdlib.h>	// EXIT_FAILURE, srand, rand, exit, mallo, free, strtol, posix_memalign
+#include <string.h>	// strlen, strcpy, strcmp, strncmp, strchr, strerror, memset
+#include <unistd.h>	// STDOUT_FILENO, sleep, sysconf, _SC_NPROCESSORS_ONLN
+#include <pthread.h>	// PTHREAD_MUTEX_RECURSIVE, PTHREAD_CREATE_JOINABLE, 
+			// pthread_cond_init, pthread_cond_wait, pthread_cond_signal, pthread_cond_destroy
+			// pthread_mutex_init, pthread_mutex_lock, pthread_mutex_unlock, pthread_mutex_destroy
+			// pthread_attr_init, pthread_attr_setdetachstate, pthread_attr_destroy
+			// pthread_mutexattr_init, pthread_mutexattr_settype, pthread_mutexattr_destroy
+			// pthread_create, pthread_join, pthread_exit, pthread_cancel
+#include <limits.h>	// LONG_MAX, LONG_MIN, INT_MAX
+#include <time.h>	// struct timespec
+#include <signal.h>	// SIGUSR1, SIG_BLOCK, sigset_t, sigemptyset, sigaddset, sigwait, pthread_sigmask
+#include "futex_waitq.h"	// futex_waitq_t, futex_waitq_init, futex_waitq_prepare, futex_waitq_cancel, futex_waitq_wait, futex_waitq_wait_timeout, futex_waitq_wake
+#include "hazard_ptr.h"	// hazard_protect, hazard_set, hazard_clear, hazard_retire, hazard_drain
+#include "node_pool.h"	// node_pool, node_pool_init, node_pool_alloc, node_pool_free, node_pool_print, node_pool_destroy
+#include "bench_report.h"	// bench_now, bench_elapsed_ms, bench_jain, bench_json_array
+#include "cpu_topology.h"	// cpu_topology_t, CPU_TOPOLOGY_COMPACT, CPU_TOPOLOGY_SCATTER, cpu_topology_load, cpu_topology_order, cpu_topology_node_set, cpu_topology_destroy
+#include "epoch.h"	// epoch_enabled, epoch_init, epoch_enter, epoch_leave, epoch_retire, epoch_drain
+#include "text_writer.h"	// text_writer_t, text_writer_init, text_writer_int, text_writer_destroy
+#include "lock_stats.h"	// lock_stats_enabled, lock_stats_mutex_lock, lock_stats_mutex_trylock, lock_stats_mutex_unlock, lock_stats_cond_wait, lock_stats_cond_signal, lock_stats_cond_broadcast, lock_stats_print, lock_stats_destroy
+
+#define INTLIST_BACKEND_MUTEX		0
+#define INTLIST_BACKEND_LOCKFREE	1
+#define INTLIST_BACKEND_UNROLLED	2
+#define INTLIST_BACKEND_TWOLOCK		3
+#define INTLIST_BACKEND_COMBINING	4
+#define INTLIST_BACKENDS_COUNT		5
+
+#define FC_IDLE		0 // States of a flat combining request (fc_request_t)
+#define FC_PENDING	1 // Published, no combiner looked at it yet
+#define FC_PARKED	2 // A combiner could not serve it yet, the owner sleeps on 'waitq'
+#define FC_DONE		3 // Served, 'result' is set
+#define FC_PUSH		0
+#define FC_POP		1
+
+#define AFFINITY_NONE		0 // '--affinity=', named in affinity_names[]
+#define AFFINITY_COMPACT	1
+#define AFFINITY_SCATTER	2
+#define AFFINITY_PAIRED		3
+#define AFFINITY_NUMA		4
+#define AFFINITY_POLICIES	5
+
+#define INTLIST_CLOSED		-2 // pop_tail_n on a closed and empty list
+#define INTLIST_SHUT_RD		1 // intlist_close(): pops return what is left, pushes still land
+#define INTLIST_SHUT_RDWR	2 // intlist_close(): pushes are refused as well
+#define LOCK_SITE_LIST		0 // Sites for lock_stats.h, named in lock_site_names[]
+#define LOCK_SITE_HEAD		1
+#define LOCK_SITE_TAIL		2
+#define LOCK_SITE_INSERT	3
+#define LOCK_SITE_GC		4
+#define LOCK_SITE_GC_LOCK	5
+#define LOCK_SITE_NOT_FULL	6
+#define LOCK_SITES		7
+
+#define MONITOR_MAX	3600000 // Largest '--monitor=', an hour in milliseconds
+#define SPIN_LIMIT	1000000 // Largest '--spin='
+#define BATCH_MAX	4096 // Largest '--wbatch=' and '--rbatch=', the threads keep a batch on their stack
+#define DRAIN_CHUNK	4096 // Values intlist_drain() hands over at once
+#define GC_LOW_PERCENT	50 // The garbage collector trims a list that reached MAX (the high watermark) down to this percent of it
+#define GC_HARD_PERCENT	150 // A writer that finds a list this full (percent of MAX) trims a slice itself, the collector fell behind
+#define GC_SLICE	1024 // Items per remove_last_k call of the garbage collector, the longest the writers and readers wait for it
+#define SPIN_MIN	16 // Adaptive spin budget of a reader before it parks, in pause instructions
+#define SPIN_MAX	4096 // Default '--spin=', a few microseconds
+#define CACHE_LINE	64
+#if defined(__x86_64__) || defined(__i386__)
+#define CPU_RELAX()	__builtin_ia32_pause() // Frees the pipeline for the sibling hyperthread and avoids the memory order flush on exit
+#elif defined(__aarch64__)
+#define CPU_RELAX()	__asm__ __volatile__("yield" ::: "memory")
+#else
+#define CPU_RELAX()	__asm__ __volatile__("" ::: "memory")
+#endif
+#define SEGMENT_BYTES	256 // Four cache lines per unrolled segment
+#define SEGMENT_VALUES	((int)((SEGMENT_BYTES-2*sizeof(void *)-2*sizeof(int))/sizeof(int)))
+
+// Define printing strings
+#define LIST_SIZE_MSG			"The size of the list is:%d\n"
+#define USAGE_NUM_LESS_THEN_ONE_MSG	"The input value must be a positive integer\n"
+#define USAGE_MSG			"Usage: %s [--backend=mutex|lockfree|unrolled|twolock|combining] [--pool[=huge]] [--wbatch=N] [--rbatch=N] [--rbatch-min=N] [--sharded] [--bounded[=try]] [--bench] [--lockstats] [--spin=N] [--affinity=none|compact|scatter|paired|numa|all] [--monitor=MS] <WNUMc> <RNUM> <MAX> <TIME>\nExiting...\n"
+#define USAGE_OPERANDS_MISSING_MSG	"Missing operands\n" USAGE_MSG
+#define USAGE_OPERANDS_SURPLUS_MSG	"Too many operands\n" USAGE_MSG
+#define USAGE_OPTION_INVALID_MSG	"Invalid option '%s'\n" USAGE_MSG
+#define MONITOR_MSG			"Monitor - snapshot of %ld items (size %d) in %.3f ms\n"
+#define ERROR_EXIT_MSG			"Exiting...\n"
+#define F_ERROR_MALLOC_LIST_MSG		"[Error] Failed to allocate memory to list.\n"
+#define F_ERROR_MALLOC_NODE_MSG		"[Error] Failed to allocate memory to node.\n"
+#define F_ERROR_MALLOC_SEGMENT_MSG	"[Error] Failed to allocate memory to segment.\n"
+#define F_ERROR_MALLOC_THREADS_MSG	"[Error] Failed to allocate memory to threads.\n"
+#define F_ERROR_GENERAL_MSG		"[Error] Error in %s: %s\n"
+#define F_ERROR_STRTOL_MSG		"[Error] Strtol failed with error: %s\n"
+// Define data types
+typedef struct intlist_node {
+	int val;
+	struct intlist_node *prev; // Previously node (Double linked list)
+	struct intlist_node *next; // Next node
+} intlist_node_t;
+typedef struct intlist_segment { // Unrolled backend
+	struct intlist_segment *prev; // Newer segment (towards the head)
+	struct intlist_segment *next; // Older segment (towards the tail)
+	int first; // Index of the newest value
+	int end; // One past the oldest value, an empty segment has first == end
+	int vals[SEGMENT_VALUES];
+} intlist_segment_t;
+typedef struct fc_request { // Combining backend: one per thread and list, written by its owner while FC_IDLE and by the combiner while published
+	int state __attribute__((aligned(CACHE_LINE))); // FC_*
+	int op; // FC_PUSH or FC_POP
+	int n; // Items to push, or most items to pop
+	int min; // Pop: fewest items to wait for. Push: 1 if it waits for room in a bounded list
+	int* out; // Pop: the values, oldest first
+	intlist_node_t* chain_head; // Push: the newest node of the chain to link. Pop: unused
+	intlist_node_t* chain_tail; // Push: its oldest node. Pop: the old tail, the popped nodes are reached through 'prev'
+	int result; // Push: 1 if linked. Pop: items popped, or INTLIST_CLOSED
+	futex_waitq_t waitq; // The owner while FC_PARKED
+	void* owner; // The owner's fc_token
+	struct fc_request* next; // Publication list, requests are only added until the list is destroyed
+} fc_request_t;
+typedef struct intlist_list {
+	// Fields that writers, readers and size() touch sit on separate cache lines, so a push does not
+	// invalidate the line a pop is using (the lock-free backend has no lock to serialize them).
+	// The list itself is allocated CACHE_LINE aligned.
+	int backend; // INTLIST_BACKEND_*
+	int capacity; // Most items the list holds, 0 is unbounded. See intlist_set_capacity()
+	int closed; // 0, INTLIST_SHUT_RD or INTLIST_SHUT_RDWR, only raised by intlist_close(), read without the lock
+	int gc_trimming; // 1 while the garbage collector or a writer (gc_assist) trims the list, never both at once
+	struct intlist_node *nil; // Pointer to the nil object
+	intlist_segment_t *seg_spare; // Unrolled backend: the last emptied segment, saves a free() & malloc() pair
+	int count __attribute__((aligned(CACHE_LINE))); // How many nodes there are in the list
+	struct intlist_node *head __attribute__((aligned(CACHE_LINE))); // First node in the list
+	struct intlist_node *lf_tail; // Lock-free backend: newest node (pushed last), may lag one node behind
+	intlist_segment_t *seg_head; // Unrolled backend: newest segment
+	pthread_mutex_t head_lock; // Two-lock backend: protects 'head', only writers take it
+	struct intlist_node *tail __attribute__((aligned(CACHE_LINE))); // Last node in the list
+	struct intlist_node *lf_head; // Lock-free backend: dummy node, its 'next' is the oldest item (popped first)
+	intlist_segment_t *seg_tail; // Unrolled backend: oldest segment
+	pthread_mutex_t tail_lock; // Two-lock backend: protects 'tail' (the dummy node), only readers take it
+	futex_waitq_t waitq __attribute__((aligned(CACHE_LINE))); // Lock-free and two-lock backends: readers waiting for an item
+	int spin; // Readers spin this many times before they park, see intlist_spin_wait()
+	futex_waitq_t waitq_full __attribute__((aligned(CACHE_LINE))); // Bounded lock-free and two-lock backends: writers waiting for room
+	int slots; // ... items in the list or reserved by a writer that is linking them, at most 'capacity'
+	pthread_mutex_t lock __attribute__((aligned(CACHE_LINE)));
+	pthread_mutexattr_t attr;
+	pthread_cond_t cond_new_insert;
+	int waiters; // Readers in pthread_cond_wait() on 'cond_new_insert', protected by 'lock'. No waiters, no signal
+	int batch_waiters; // Those of them in pop_tail_n() waiting for more than one item, protected by 'lock'
+	pthread_cond_t cond_not_full; // Bounded mutex and unrolled backends: writers waiting for room
+	int full_waiters; // Writers in pthread_cond_wait() on 'cond_not_full', protected by 'lock'
+	fc_request_t* fc_requests; // Combining backend: the publication list, the combiner holds 'lock'
+	long fc_id; // Unique per intlist_init_backend(), tells fc_self() this list from an older one at the same address
+} intlist;
+typedef struct intlist_shards { // The lists the threads work on, one per writer in sharded mode, a single one otherwise
+	int count;
+	intlist **lists;
+	futex_waitq_t waitq __attribute__((aligned(CACHE_LINE))); // Readers that found every shard empty
+	int spin; // See intlist_spin_wait()
+	int closed; // Set by intlist_shards_close(), after every shard was closed for the readers
+} intlist_shards_t;
+typedef struct thread_args {
+	intlist_shards_t *shards;
+	int id; // Index among the writers, or among the readers
+	long ops; // Items pushed (writers) or popped (readers), set when the thread stops
+	long rejected; // Items a writer could not push ('--bounded=try')
+	double seconds; // How long the thread ran
+} thread_args_t;
+typedef struct timer_args { // Step 7, the threads thrd_timer() stops and joins
+	intlist_shards_t *shards;
+	pthread_t *threads_writers;
+	pthread_t *threads_readers;
+} timer_args_t;
+typedef struct gc_stats { // Written by the garbage collector, read after it was joined
+	long runs; // remove_last_k calls (slices of at most GC_SLICE items)
+	long removed;
+	double pause_total; // Milliseconds spent in remove_last_k
+	double pause_max;
+	long size_max; // Largest shard size the collector saw, how far the list overshot MAX
+	long assists; // Slices the writers trimmed themselves (gc_assist), updated atomically
+	long assist_removed;
+} gc_stats_t;
+// Define global variables
+int threads_gc_run = 1; // The run flags are read and written atomically, the threads poll them without a lock
+int threads_writers_run = 1;
+int threads_readers_run = 1;
+int global_writers = 0;
+int global_readers = 0;
+int global_max = 0;
+int global_time = 0;
+int global_backend = INTLIST_BACKEND_MUTEX;
+int global_writers_batch = 1; // '--wbatch=', values pushed per lock acquisition
+int global_readers_batch = 1; // '--rbatch=', most values popped per lock acquisition
+int global_readers_batch_min = 1; // '--rbatch-min=', a reader waits until this many values are available
+int global_pool = 0; // '--pool' (1) or '--pool=huge' (2), nodes come from node_pool.h instead of malloc()
+int global_sharded = 0; // '--sharded', one list per writer
+int global_bounded = 0; // '--bounded' (1): a full list blocks the writers, '--bounded=try' (2): they drop the batch
+int global_shard_max = 0; // The garbage collector trims a shard once it holds this many items (high watermark)
+int global_shard_low = 0; // ... down to this many (low watermark)
+int global_shard_hard = 0; // The writers trim a shard themselves once it holds this many items
+int global_gc_pending = 0; // A writer saw a shard at the high watermark, protected by 'gc_lock' (read atomically without it)
+int global_bench = 0; // '--bench', JSON statistics of a backend and thread count matrix instead of the list
+int global_affinity = AFFINITY_NONE; // '--affinity=', where the threads of a run are placed
+cpu_topology_t global_topology; // Loaded once an '--affinity=' other than none was given
+int* global_cpu_order = NULL; // global_topology in the order of the current run's policy
+int global_monitor = 0; // '--monitor=', milliseconds between two snapshots, 0 for no monitor thread
+int global_spin_max = SPIN_MAX; // '--spin=', the most a reader spins before it parks. 0 on a single CPU, where the writer cannot run meanwhile
+gc_stats_t global_gc_stats;
+long global_fc_ids = 0; // Last fc_id handed out
+__thread char fc_token; // Its address names the thread in the requests it owns
+__thread fc_request_t* fc_self_req = NULL; // The request of the list the thread used last ...
+__thread long fc_self_id = 0; // ... and that list's fc_id
+int global_lock_stats = 0; // '--lockstats', 1 while thread_lock_stats runs
+pthread_t thread_lock_stats; // Prints the lock statistics on SIGUSR1
+sigset_t lock_stats_signals; // SIGUSR1, blocked in every thread so only sigwait() receives it
+const char *backend_names[] = {"mutex","lockfree","unrolled","twolock","combining"}; // Indexed by INTLIST_BACKEND_*
+const char *lock_site_names[] = {"list->lock","list->head_lock","list->tail_lock","list->cond_new_insert","count_garbage_collector","gc_lock","list->cond_not_full"}; // Indexed by LOCK_SITE_*
+const char *bounded_names[] = {"off","block","try"}; // Indexed by global_bounded
+const char *affinity_names[] = {"none","compact","scatter","paired","numa"}; // Indexed by AFFINITY_*
+pthread_attr_t attr;
+pthread_attr_t attr_placed; // 'attr' plus the CPU set of the thread that is created next ('--affinity=')
+pthread_cond_t count_garbage_collector;
+futex_waitq_t monitor_waitq; // The monitor sleeps on it between snapshots, thrd_timer() wakes it when the readers stop
+pthread_mutex_t gc_lock; // Protects global_gc_pending and threads_gc_run, 'count_garbage_collector' waits on it
+// Function declaration
+intlist_node_t* intlist_node_new(void);
+void intlist_node_free(void* node);
+void intlist_node_release(void* node);
+void intlist_init(intlist* list);
+void intlist_init_backend(intlist* list, int backend);
+void intlist_destroy(intlist** list);
+void intlist_push_head(intlist* list, int value);
+int intlist_pop_tail(intlist* list);
+void intlist_push_head_n(intlist* list, const int* vals, int n);
+int intlist_try_push_head(intlist* list, int value);
+int intlist_try_push_head_n(intlist* list, const int* vals, int n);
+void intlist_set_capacity(intlist* list, int capacity);
+void intlist_close(intlist* list, int how);
+int intlist_pop_tail_n(intlist* list, int* out, int max, int min);
+int intlist_remove_last_k(intlist* list, int k);
+int intlist_drain(intlist* list, void (*consume)(void* arg, const int* vals, int n), void* arg);
+int intlist_snapshot(intlist* list, void (*consume)(void* arg, const int* vals, int n), void* arg);
+int intlist_size(intlist* list);
+pthread_mutex_t* intlist_get_mutex(intlist* list);
+void intlist_shards_init(intlist_shards_t* shards, int count, int backend);
+void intlist_shards_destroy(intlist_shards_t** shards);
+void intlist_shards_push_head_n(intlist_shards_t* shards, int shard, const int* vals, int n);
+int intlist_shards_try_push_head_n(intlist_shards_t* shards, int shard, const int* vals, int n);
+int intlist_shards_pop_tail_n(intlist_shards_t* shards, int home, int* out, int max, int min);
+int intlist_shards_size(intlist_shards_t* shards);
+void intlist_shards_close(intlist_shards_t* shards, int how);
+pthread_mutex_t* intlist_shards_get_mutex(intlist_shards_t* shards);
+
+// Threads
+void gc_trigger(void) { // Wake the garbage collector, it cannot miss the wakeup
+	// The flag is set under 'gc_lock', so the collector either sees it before it waits or gets the signal.
+	// Once set, the writers only read it until the collector takes it, so a full list costs them no lock.
+	int rc; // Variable for pthread_mutex_lock & pthread_mutex_unlock & pthread_cond_signal
+	if (__atomic_load_n(&global_gc_pending,__ATOMIC_RELAXED)) {
+		return;
+	}
+	if ((rc = lock_stats_mutex_lock(&gc_lock,LOCK_SITE_GC_LOCK)) != 0) { // If successful, the pthread_mutex_lock() function shall return zero; otherwise, an error number shall be returned to indicate the error.
+		fprintf(stderr,F_ERROR_GENERAL_MSG,"pthread_mutex_lock()",strerror(rc));
+		exit(EXIT_FAILURE);
+	}
+	__atomic_store_n(&global_gc_pending,1,__ATOMIC_RELAXED);
+	if ((rc = lock_stats_cond_signal(&count_garbage_collector,LOCK_SITE_GC)) != 0) { // If successful, the pthread_cond_signal() function shall return zero; otherwise, an error number shall be returned to indicate the error.
+		fprintf(stderr,F_ERROR_GENERAL_MSG,"pthread_cond_signal()",strerror(rc));
+		exit(EXIT_FAILURE);
+	}
+	if ((rc = lock_stats_mutex_unlock(&gc_lock,LOCK_SITE_GC_LOCK)) != 0) { // If successful, the pthread_mutex_unlock() function shall return zero; otherwise, an error number shall be returned to indicate the error.
+		fprintf(stderr,F_ERROR_GENERAL_MSG,"pthread_mutex_unlock()",strerror(rc));
+		exit(EXIT_FAILURE);
+	}
+}
+int gc_trim_begin(intlist* list) { // Take the right to trim 'list', returns 0 if the collector or another writer has it
+	// One trimmer at a time: two that both read the size and cut down to the low watermark would cut it twice.
+	int expected = 0;
+	return __atomic_compare_exchange_n(&(list->gc_trimming),&expected,1,0,__ATOMIC_ACQUIRE,__ATOMIC_RELAXED);
+}
+void gc_trim_end(intlist* list) {
+	__atomic_store_n(&(list->gc_trimming),0,__ATOMIC_RELEASE);
+}
+void gc_assist(intlist* list) { // A writer trims a slice of 'list' itself, the collector cannot keep up
+	int k_slice;
+	int removed;
+	if (!gc_trim_begin(list)) { // Already being trimmed, the size is coming down
+		return;
+	}
+	k_slice = intlist_size(list)-global_shard_low;
+	if (GC_SLICE < k_slice) {
+		k_slice = GC_SLICE;
+	}
+	if ((0 < k_slice)&&(0 < (removed = intlist_remove_last_k(list,k_slice)))) {
+		__atomic_add_fetch(&global_gc_stats.assists,1,__ATOMIC_RELAXED);
+		__atomic_add_fetch(&global_gc_stats.assist_removed,removed,__ATOMIC_RELAXED);
+	}
+	gc_trim_end(list);
+}
+void *thrd_writers(void *argStruct) {
+	// Writers - writer threads push random integers to the list, in an infinite loop.
+	int i;
+	int vals[global_writers_batch];
+	int size;
+	long ops = 0;
+	long rejected = 0;
+	struct timespec t_start,t_end;
+	thread_args_t* args = argStruct;
+	int shard = args->id % args->shards->count; // Its own list in sharded mode
+	intlist* list = args->shards->lists[shard];
+	// Push new nodes
+	srand(time(NULL));
+	bench_now(&t_start);
+	while (__atomic_load_n(&threads_writers_run,__ATOMIC_RELAXED)) {
+		for (i = 0; i < global_writers_batch; i++) { // '--wbatch=', one lock acquisition per batch
+			vals[i] = rand();
+		}
+		if (global_bounded == 2) { // '--bounded=try', a full list rejects the whole batch
+			if (!intlist_shards_try_push_head_n(args->shards, shard, vals, global_writers_batch)) {
+				rejected += global_writers_batch;
+				continue;
+			}
+		} else {
+			intlist_shards_push_head_n(args->shards, shard, vals, global_writers_batch); // Waits for room in bounded mode
+		}
+		ops += global_writers_batch;
+		if (global_bounded) { // The list cannot pass MAX, nothing to collect
+			continue;
+		}
+		if ((size = intlist_size(list)) >= global_shard_max) { // Wakeup the garbage collector
+			gc_trigger();
+			if (size >= global_shard_hard) { // ... and help it, it fell behind
+				gc_assist(list);
+			}
+		}
+	}
+	bench_now(&t_end);
+	args->ops = ops;
+	args->rejected = rejected;
+	args->seconds = bench_elapsed_ms(&t_start,&t_end)/1000;
+	// Finish, thrd_timer() joins the thread
+	pthread_exit(NULL);
+}
+void *thrd_readers(void *argStruct) {
+	// Readers – reader threads pop integers from the list, in an infinite loop.
+	int n;
+	int vals[global_readers_batch];
+	long ops = 0;
+	struct timespec t_start,t_end;
+	thread_args_t* args = argStruct;
+	// Pop nodes
+	bench_now(&t_start);
+	while (__atomic_load_n(&threads_readers_run,__ATOMIC_RELAXED)) { // '--rbatch=', takes what is there (at least '--rbatch-min=') up to a full batch
+		if ((n = intlist_shards_pop_tail_n(args->shards, args->id, vals, global_readers_batch, global_readers_batch_min)) == INTLIST_CLOSED) { // Empty and closed, the run is over
+			break;
+		}
+		ops += n;
+	}
+	bench_now(&t_end);
+	args->ops = ops;
+	args->seconds = bench_elapsed_ms(&t_start,&t_end)/1000;
+	// Finish, thrd_timer() joins the thread
+	pthread_exit(NULL);
+}
+void *thrd_garbage_collector(void *argStruct) {
+	intlist_shards_t* shards = argStruct;
+	// Garbage Collector – the garbage collector waits until the list has more than MAX items. Once it
+	// has, the garbage collector removes half of the elements in the list (from the tail, rounded up).
+	// In addition, the garbage collector prints the number of items removed from the list. Output a
+	// message like the following: "GC – 7 items removed from the list".
+	// MAX is the high watermark, the list is trimmed down to the low one (GC_LOW_PERCENT of MAX, half by
+	// default) in slices of GC_SLICE items. Every slice takes the list lock on its own, so the writers and
+	// readers run between the slices instead of waiting for one big cut. When the writers push faster than
+	// the collector trims, they reach the hard watermark and help (gc_assist), which bounds the list.
+	// In sharded mode every shard is checked against its share of MAX and trimmed on its own. A pass takes at
+	// most one slice from every shard over it, round-robin, so one shard the writers keep filling does not hold
+	// the collector while the others grow. A shard a writer trims right now (gc_assist) waits for the next pass.
+	int rc; // Variable for pthread_mutex_lock & pthread_mutex_unlock & pthread_cond_wait
+	int k_to_remove[shards->count]; // Removed from the shard since it passed MAX, -1 while it is not trimmed
+	int trimming; // Shards still above their low watermark after this pass
+	int k_slice;
+	int removed;
+	int size;
+	int waits = 0; // Waits since the last one that found a shard to trim, for lock_stats_cond_wait()
+	int shard;
+	struct timespec t_start,t_end;
+	double pause;
+	intlist* list;
+	// Lock
+	if ((rc = lock_stats_mutex_lock(&gc_lock,LOCK_SITE_GC_LOCK)) != 0) { // If successful, the pthread_mutex_lock() function shall return zero; otherwise, an error number shall be returned to indicate the error.
+		fprintf(stderr,F_ERROR_GENERAL_MSG,"pthread_mutex_lock()",strerror(rc));
+		exit(EXIT_FAILURE);
+	}
+	// Wait & Clean
+	while (threads_gc_run) {
+		// Sleep, unless a writer set the flag while the last pass ran
+		if (!global_gc_pending) {
+			if ((rc = lock_stats_cond_wait(&count_garbage_collector, &gc_lock, LOCK_SITE_GC, LOCK_SITE_GC_LOCK, &waits)) != 0) { // Upon successful completion, a value of zero shall be returned; otherwise, an error number shall be returned to indicate the error.
+				fprintf(stderr,F_ERROR_GENERAL_MSG,"pthread_cond_wait()",strerror(rc));
+				exit(EXIT_FAILURE);
+			}
+			continue; // Spurious wakeup or stop, check both again
+		}
+		// Take the flag before looking at the lists, a writer that reaches the watermark from now on sets it again
+		__atomic_store_n(&global_gc_pending,0,__ATOMIC_RELAXED);
+		if ((rc = lock_stats_mutex_unlock(&gc_lock,LOCK_SITE_GC_LOCK)) != 0) { // If successful, the pthread_mutex_unlock() function shall return zero; otherwise, an error number shall be returned to indicate the error.
+			fprintf(stderr,F_ERROR_GENERAL_MSG,"pthread_mutex_unlock()",strerror(rc));
+			exit(EXIT_FAILURE);
+		}
+		// Clean, pass after pass until every shard is down to its low watermark
+		for (shard = 0; shard < shards->count; shard++) {
+			k_to_remove[shard] = -1;
+		}
+		waits = 0;
+		trimming = 1;
+		while ((trimming)&&(__atomic_load_n(&threads_gc_run,__ATOMIC_RELAXED))) {
+			trimming = 0;
+			for (shard = 0; shard < shards->count; shard++) {
+				list = shards->lists[shard];
+				if ((k_to_remove[shard] < 0)&&(intlist_size(list) < global_shard_max)) { // Not over MAX, or the readers got there first
+					continue;
+				}
+				if (k_to_remove[shard] < 0) {
+					k_to_remove[shard] = 0;
+				}
+				if (!gc_trim_begin(list)) { // A writer trims a slice (gc_assist), the size is read again in the next pass
+					trimming = 1;
+					continue;
+				}
+				if ((size = intlist_size(list)) <= global_shard_low) {
+					gc_trim_end(list);
+					if ((!global_bench)&&(0 < k_to_remove[shard])) { // Nothing to report if the readers emptied it meanwhile
+						printf("GC - %d items removed from the list\n",k_to_remove[shard]);
+					}
+					k_to_remove[shard] = -1;
+					continue;
+				}
+				if (global_gc_stats.size_max < size) {
+					global_gc_stats.size_max = size;
+				}
+				k_slice = size-global_shard_low;
+				if (GC_SLICE < k_slice) {
+					k_slice = GC_SLICE;
+				}
+				bench_now(&t_start);
+				removed = intlist_remove_last_k(list,k_slice); // Takes and releases the list lock, fewer if the readers took some
+				bench_now(&t_end);
+				gc_trim_end(list);
+				pause = bench_elapsed_ms(&t_start,&t_end);
+				k_to_remove[shard] += removed;
+				global_gc_stats.runs += 1;
+				global_gc_stats.removed += removed;
+				global_gc_stats.pause_total += pause;
+				if (global_gc_stats.pause_max < pause) {
+					global_gc_stats.pause_max = pause;
+				}
+				trimming = 1; // Until a pass finds it at the low watermark
+			}
+		}
+		for (shard = 0; shard < shards->count; shard++) { // Stopped while trimming
+			if ((!global_bench)&&(0 < k_to_remove[shard])) {
+				printf("GC - %d items removed from the list\n",k_to_remove[shard]);
+			}
+		}
+		// Lock again for pthread_cond_wait()
+		if ((rc = lock_stats_mutex_lock(&gc_lock,LOCK_SITE_GC_LOCK)) != 0) { // If successful, the pthread_mutex_lock() function shall return zero; otherwise, an error number shall be returned to indicate the error.
+			fprintf(stderr,F_ERROR_GENERAL_MSG,"pthread_mutex_lock()",strerror(rc));
+			exit(EXIT_FAILURE);
+		}
+	}
+	// Unlock
+	if ((rc = lock_stats_mutex_unlock(&gc_lock,LOCK_SITE_GC_LOCK)) != 0) { // If successful, the pthread_mutex_unlock() function shall return zero; otherwise, an error number shall be returned to indicate the error.
+		fprintf(stderr,F_ERROR_GENERAL_MSG,"pthread_mutex_unlock()",strerror(rc));
+		exit(EXIT_FAILURE);
+	}
+	// Finish
+	pthread_exit(NULL);
+}
+void *thrd_timer(void *argStruct) {
+	int i;
+	int rc; // Variable for pthread_join & pthread_mutex_lock & pthread_mutex_unlock & pthread_cond_signal
+	timer_args_t* args = argStruct;
+	// 6. Sleep for TIME seconds.
+	sleep(global_time);
+	// 7. Stop all running threads (safely, avoid deadlocks!)
+	__atomic_store_n(&threads_readers_run,0,__ATOMIC_SEQ_CST); // Stop readers threads
+	futex_waitq_wake(&monitor_waitq,1); // ... and the monitor ('--monitor='), in the middle of its wait
+	intlist_shards_close(args->shards,INTLIST_SHUT_RD); // Readers waiting for an item return at once, the writers go on
+	for (i = 0; i < global_readers; i++) { // Wait until all pthreads die gracefully
+		if ((rc = pthread_join(args->threads_readers[i], NULL)) != 0) { // On success, pthread_join() returns 0; on error, it returns an error number.
+			fprintf(stderr,F_ERROR_GENERAL_MSG,"readers pthread_join()",strerror(rc));
+			exit(EXIT_FAILURE);
+		}
+	}
+	__atomic_store_n(&threads_writers_run,0,__ATOMIC_SEQ_CST); // Stop writers threads
+	intlist_shards_close(args->shards,INTLIST_SHUT_RDWR); // Nobody makes room anymore, writers waiting for it return
+	for (i = 0; i < global_writers; i++) { // Wait until all pthreads die gracefully
+		if ((rc = pthread_join(args->threads_writers[i], NULL)) != 0) { // On success, pthread_join() returns 0; on error, it returns an error number.
+			fprintf(stderr,F_ERROR_GENERAL_MSG,"writers pthread_join()",strerror(rc));
+			exit(EXIT_FAILURE);
+		}
+	}
+	// Stop Garbage Collector thread, under its lock so the signal cannot come before it waits
+	if ((rc = lock_stats_mutex_lock(&gc_lock,LOCK_SITE_GC_LOCK)) != 0) { // If successful, the pthread_mutex_lock() function shall return zero; otherwise, an error number shall be returned to indicate the error.
+		fprintf(stderr,F_ERROR_GENERAL_MSG,"pthread_mutex_lock()",strerror(rc));
+		exit(EXIT_FAILURE);
+	}
+	__atomic_store_n(&threads_gc_run,0,__ATOMIC_RELAXED);
+	if ((rc = lock_stats_cond_signal(&count_garbage_collector,LOCK_SITE_GC)) != 0) { // If successful, the pthread_cond_signal() function shall return zero; otherwise, an error number shall be returned to indicate the error.
+		fprintf(stderr,F_ERROR_GENERAL_MSG,"pthread_cond_signal()",strerror(rc));
+		exit(EXIT_FAILURE);
+	}
+	if ((rc = lock_stats_mutex_unlock(&gc_lock,LOCK_SITE_GC_LOCK)) != 0) { // If successful, the pthread_mutex_unlock() function shall return zero; otherwise, an error number shall be returned to indicate the error.
+		fprintf(stderr,F_ERROR_GENERAL_MSG,"pthread_mutex_unlock()",strerror(rc));
+		exit(EXIT_FAILURE);
+	}
+	// Finish
+	pthread_exit(NULL);
+}
+void count_values(void* arg, const int* vals, int n) { // The intlist_snapshot() consumer of the monitor, counts the values into the long 'arg'
+	(void)vals;
+	*(long *)arg += n;
+}
+void *thrd_monitor(void *argStruct) {
+	// '--monitor=MS' - snapshots every list each MS milliseconds while the readers run, without taking a lock,
+	// and prints how many items it saw, the size the list reported and how long the walk took. The wait ends
+	// early when the readers stop, so a long interval does not hold up run_once().
+	intlist_shards_t* shards = argStruct;
+	struct timespec delay = {global_monitor/1000,(global_monitor%1000)*1000000L};
+	struct timespec t_start,t_end;
+	long seen;
+	int seq;
+	int size;
+	int shard;
+	while (1) {
+		seq = futex_waitq_prepare(&monitor_waitq);
+		if (!__atomic_load_n(&threads_readers_run,__ATOMIC_SEQ_CST)) { // Stopped before it sleeps
+			futex_waitq_cancel(&monitor_waitq);
+			break;
+		}
+		futex_waitq_wait_timeout(&monitor_waitq,seq,&delay); // Woken early by thrd_timer(), or by a signal
+		if (!__atomic_load_n(&threads_readers_run,__ATOMIC_SEQ_CST)) { // No snapshot after the run
+			break;
+		}
+		seen = 0;
+		size = intlist_shards_size(shards);
+		bench_now(&t_start);
+		for (shard = 0; shard < shards->count; shard++) {
+			intlist_snapshot(shards->lists[shard],count_values,&seen);
+		}
+		bench_now(&t_end);
+		fprintf(stderr,MONITOR_MSG,seen,size,bench_elapsed_ms(&t_start,&t_end));
+	}
+	pthread_exit(NULL);
+}
+void *thrd_lock_stats() {
+	// '--lockstats' - prints the lock statistics to stderr on every SIGUSR1, until it is cancelled.
+	int sig;
+	while (1) {
+		if (sigwait(&lock_stats_signals,&sig) == 0) { // sigwait() is a cancellation point. On success, sigwait() returns 0.
+			lock_stats_print(stderr,lock_site_names,LOCK_SITES);
+		}
+	}
+	return NULL;
+}
+// Functions
+void lock_stats_finish(void) { // Stop the SIGUSR1 thread and print the final lock statistics, once
+	int rc; // Variable for pthread_cancel & pthread_join
+	if (!global_lock_stats) {
+		return;
+	}
+	global_lock_stats = 0;
+	if ((rc = pthread_cancel(thread_lock_stats)) != 0) { // On success, pthread_cancel() returns 0; on error, it returns a nonzero error number.
+		fprintf(stderr,F_ERROR_GENERAL_MSG,"pthread_cancel()",strerror(rc));
+	} else if ((rc = pthread_join(thread_lock_stats, NULL)) != 0) { // On success, pthread_join() returns 0; on error, it returns an error number.
+		fprintf(stderr,F_ERROR_GENERAL_MSG,"pthread_join()",strerror(rc));
+	}
+	lock_stats_print(stderr,lock_site_names,LOCK_SITES);
+}
+int program_end(int error, intlist_shards_t* shards, pthread_t* threads_writers, pthread_t* threads_readers, thread_args_t* threads_args) {
+	int res = 0;
+	int rc = 0;
+	if (threads_writers) {
+		free(threads_writers);
+		threads_writers = NULL;
+	}
+	if (threads_readers) {
+		free(threads_readers);
+		threads_readers = NULL;
+	}
+	if (threads_args) {
+		free(threads_args);
+		threads_args = NULL;
+	}
+	if (shards) {
+		intlist_shards_destroy(&shards);
+	}
+	epoch_drain(); // What the snapshots kept alive, before the slabs go
+	node_pool_destroy(); // After the lists, their nodes live in the slabs
+	lock_stats_finish();
+	lock_stats_destroy();
+	if ((rc = pthread_cond_destroy(&count_garbage_collector)) != 0) { // If successful, the pthread_cond_destroy() function shall return zero; otherwise, an error number shall be returned to indicate the error.
+		fprintf(stderr,F_ERROR_GENERAL_MSG,"pthread_cond_destroy()",strerror(rc));
+		res = -1;
+	}
+	if ((rc = pthread_mutex_destroy(&gc_lock)) != 0) { // If successful, the pthread_mutex_destroy() function shall return zero; otherwise, an error number shall be returned to indicate the error.
+		fprintf(stderr,F_ERROR_GENERAL_MSG,"pthread_mutex_destroy()",strerror(rc));
+		res = -1;
+	}
+	if ((rc = pthread_attr_destroy(&attr)) != 0) { // On success, these functions return 0; on error, they return a nonzero error number.
+		fprintf(stderr,F_ERROR_GENERAL_MSG,"pthread_attr_destroy()",strerror(rc));
+		res = -1;
+	}
+	if (global_cpu_order) { // '--affinity='
+		free(global_cpu_order);
+		global_cpu_order = NULL;
+		cpu_topology_destroy(&global_topology);
+		if ((rc = pthread_attr_destroy(&attr_placed)) != 0) { // On success, these functions return 0; on error, they return a nonzero error number.
+			fprintf(stderr,F_ERROR_GENERAL_MSG,"pthread_attr_destroy()",strerror(rc));
+			res = -1;
+		}
+	}
+	if ((error == -1)||(res == -1)) {
+		fprintf(stderr,ERROR_EXIT_MSG);
+	}
+	return res;
+}
+int placement_slot(int reader, int id) { // Position of writer or reader 'id' in the CPU order of the run, the garbage collector comes last
+	int pairs = (global_writers < global_readers) ? global_writers : global_readers;
+	if (global_affinity == AFFINITY_PAIRED) { // Writer i and reader i side by side, the threads without a partner after the pairs
+		return (id < pairs) ? 2*id+reader : pairs+id;
+	}
+	return reader ? global_writers+id : id;
+}
+pthread_attr_t* placement_attr(int slot, int shard) { // The attributes for the thread at 'slot' that works on 'shard' ('--affinity=')
+	cpu_set_t set;
+	int rc; // Variable for pthread_attr_setaffinity_np
+	if (global_affinity == AFFINITY_NONE) {
+		return &attr;
+	}
+	if (global_affinity == AFFINITY_NUMA) {
+		cpu_topology_node_set(&global_topology,shard % global_topology.nodes,&set);
+	} else {
+		CPU_ZERO(&set);
+		CPU_SET(global_cpu_order[slot % global_topology.count],&set);
+	}
+	if ((rc = pthread_attr_setaffinity_np(&attr_placed,sizeof(cpu_set_t),&set)) != 0) { // On success, these functions return 0; on error, they return a nonzero error number.
+		fprintf(stderr,F_ERROR_GENERAL_MSG,"pthread_attr_setaffinity_np()",strerror(rc));
+		exit(EXIT_FAILURE);
+	}
+	return &attr_placed;
+}
+int run_once(intlist_shards_t* shards, pthread_t* threads_writers, pthread_t* threads_readers, thread_args_t* threads_args) { // Steps 3 to 7 on 'shards' with global_writers writers and global_readers readers
+	// Returns 0 once every thread was joined, or -1 if a thread could not be created or joined.
+	int i;
+	int rc; // Variable for pthread_create & pthread_join
+	int pthread_create_try = 0;
+	pthread_t threads_support[3]; // Garbage collector, timer and the monitor ('--monitor=')
+	timer_args_t timer_args = {shards,threads_writers,threads_readers};
+	threads_gc_run = 1;
+	global_gc_pending = 0;
+	threads_writers_run = 1;
+	threads_readers_run = 1;
+	futex_waitq_init(&monitor_waitq);
+	memset(&global_gc_stats,0,sizeof(gc_stats_t));
+	if (global_affinity != AFFINITY_NONE) {
+		cpu_topology_order(&global_topology,(global_affinity == AFFINITY_SCATTER) ? CPU_TOPOLOGY_SCATTER : CPU_TOPOLOGY_COMPACT,global_cpu_order);
+	}
+	// 3. Create a thread for the garbage collector.
+	if ((rc = pthread_create(&threads_support[0], placement_attr(global_writers+global_readers,0), thrd_garbage_collector, shards)) != 0) { // On success, pthread_create() returns 0; on error, it returns an error number, and the contents of *thread are undefined.
+		fprintf(stderr,F_ERROR_GENERAL_MSG,"GC pthread_create()",strerror(rc));
+		return -1;
+	}
+	// 4. Create WNUM threads for the writers.
+	for (i=0;i<global_writers;i++) {
+		threads_args[i].shards = shards;
+		threads_args[i].id = i;
+		pthread_create_try = 0;
+		while (pthread_create_try < 2) { // Give it two tries
+			if ((rc = pthread_create(&threads_writers[i], placement_attr(placement_slot(0,i),i % shards->count), thrd_writers, &threads_args[i])) != 0) { // On success, pthread_create() returns 0; on error, it returns an error number, and the contents of *thread are undefined.
+				if (pthread_create_try == 0) { // pthread_create failed for the first time
+					pthread_create_try += 1;
+					sleep(1);
+				} else { // pthread_create failed for the second time
+					fprintf(stderr,F_ERROR_GENERAL_MSG,"writers pthread_create()",strerror(rc));
+					return -1;
+				}
+			} else {
+				pthread_create_try = 2;
+			}
+		}
+	}
+	// 5. Create RNUM threads for the readers.
+	for (i=0;i<(int)global_readers;i++) {
+		threads_args[global_writers+i].shards = shards;
+		threads_args[global_writers+i].id = i;
+		pthread_create_try = 0;
+		while (pthread_create_try < 2) { // Give it two tries
+			if ((rc = pthread_create(&threads_readers[i], placement_attr(placement_slot(1,i),i % shards->count), thrd_readers, &threads_args[global_writers+i])) != 0) { // On success, pthread_create() returns 0; on error, it returns an error number, and the contents of *thread are undefined.
+				if (pthread_create_try == 0) { // pthread_create failed for the first time
+					pthread_create_try += 1;
+					sleep(1);
+				} else { // pthread_create failed for the second time
+					fprintf(stderr,F_ERROR_GENERAL_MSG,"readers pthread_create()",strerror(rc));
+					return -1;
+				}
+			} else {
+				pthread_create_try = 2;
+			}
+		}
+	}
+	// 6. Sleep for TIME seconds.
+	// 7. Stop all running threads (safely, avoid deadlocks!)
+	if ((rc = pthread_create(&threads_support[1], &attr, thrd_timer, &timer_args)) != 0) { // On success, pthread_create() returns 0; on error, it returns an error number, and the contents of *thread are undefined.
+		fprintf(stderr,F_ERROR_GENERAL_MSG,"timer pthread_create()",strerror(rc));
+		return -1;
+	}
+	if ((global_monitor)&&((rc = pthread_create(&threads_support[2], &attr, thrd_monitor, shards)) != 0)) { // On success, pthread_create() returns 0; on error, it returns an error number, and the contents of *thread are undefined.
+		fprintf(stderr,F_ERROR_GENERAL_MSG,"monitor pthread_create()",strerror(rc));
+		return -1;
+	}
+	// Join the support threads, the timer joined the readers and writers
+	for (i=0;i<(global_monitor ? 3 : 2);i++) {
+		if ((rc = pthread_join(threads_support[i], NULL)) != 0) { // On success, pthread_join() returns 0; on error, it returns an error number.
+			fprintf(stderr,F_ERROR_GENERAL_MSG,"pthread_join()",strerror(rc));
+			return -1;
+		}
+	}
+	return 0;
+}
+intlist_shards_t* run_prepare(int backend) { // Step 1 for a run: the list, one per writer in sharded mode. NULL if it could not be allocated.
+	int i;
+	intlist_shards_t* shards;
+	if (posix_memalign((void **)&shards,CACHE_LINE,sizeof(intlist_shards_t)) != 0) { // posix_memalign() returns zero on success, or one of the error values listed in the next section on failure.
+		fprintf(stderr,F_ERROR_MALLOC_LIST_MSG);
+		return NULL;
+	}
+	intlist_shards_init(shards,global_sharded ? global_writers : 1,backend);
+	global_shard_max = (global_max+shards->count-1)/shards->count; // The garbage collector trims each shard at its share of MAX
+	global_shard_low = (int)(((long)global_shard_max*GC_LOW_PERCENT)/100); // ... down to GC_LOW_PERCENT of it
+	global_shard_hard = (int)(((long)global_shard_max*GC_HARD_PERCENT)/100);
+	if (global_bounded) { // '--bounded', the writers wait (or give up) at the share of MAX instead of the garbage collector trimming it
+		for (i = 0; i < shards->count; i++) {
+			intlist_set_capacity(shards->lists[i],global_shard_max);
+		}
+	}
+	return shards;
+}
+void bench_report(FILE* stream, int first, int backend, intlist_shards_t* shards, thread_args_t* threads_args) { // One JSON object for the run that just finished
+	int i;
+	double push = 0;
+	double pop = 0;
+	double rejected = 0;
+	double writers_rate[global_writers]; // Items per second of every thread, over the time it ran
+	double readers_rate[global_readers];
+	for (i = 0; i < global_writers; i++) {
+		writers_rate[i] = (0 < threads_args[i].seconds) ? threads_args[i].ops/threads_args[i].seconds : 0;
+		push += writers_rate[i];
+		rejected += (0 < threads_args[i].seconds) ? threads_args[i].rejected/threads_args[i].seconds : 0;
+	}
+	for (i = 0; i < global_readers; i++) {
+		readers_rate[i] = (0 < threads_args[global_writers+i].seconds) ? threads_args[global_writers+i].ops/threads_args[global_writers+i].seconds : 0;
+		pop += readers_rate[i];
+	}
+	fprintf(stream,"%s{\"backend\":\"%s\",\"shards\":%d,\"writers\":%d,\"readers\":%d,\"max\":%d,\"time\":%d,\"wbatch\":%d,\"rbatch\":%d,\"rbatch_min\":%d,\"pool\":%d,\"bounded\":\"%s\",\"affinity\":\"%s\",",first ? "" : ",\n",backend_names[backend],shards->count,global_writers,global_readers,global_max,global_time,global_writers_batch,global_readers_batch,global_readers_batch_min,global_pool,bounded_names[global_bounded],affinity_names[global_affinity]);
+	fprintf(stream,"\"push_per_sec\":%.0f,\"pop_per_sec\":%.0f,\"total_per_sec\":%.0f,\"rejected_per_sec\":%.0f,",push,pop,push+pop,rejected);
+	bench_json_array(stream,"writers_per_sec",writers_rate,global_writers);
+	fprintf(stream,",");
+	bench_json_array(stream,"readers_per_sec",readers_rate,global_readers);
+	fprintf(stream,",\"fairness_writers\":%.4f,\"fairness_readers\":%.4f,",bench_jain(writers_rate,global_writers),bench_jain(readers_rate,global_readers));
+	fprintf(stream,"\"gc\":{\"runs\":%ld,\"removed\":%ld,\"pause_total_ms\":%.3f,\"pause_max_ms\":%.3f,\"pause_mean_ms\":%.3f,\"size_max\":%ld,\"assists\":%ld,\"assist_removed\":%ld}}",global_gc_stats.runs,global_gc_stats.removed,global_gc_stats.pause_total,global_gc_stats.pause_max,(0 < global_gc_stats.runs) ? global_gc_stats.pause_total/global_gc_stats.runs : 0.0,global_gc_stats.size_max,global_gc_stats.assists,global_gc_stats.assist_removed);
+	fflush(stream);
+}
+int bench_matrix(int backend_first, int backend_last, int affinity_first, int affinity_last, pthread_t* threads_writers, pthread_t* threads_readers, thread_args_t* threads_args) { // '--bench' - a JSON array with one object per run
+	// Every backend from backend_first to backend_last runs with every placement from affinity_first to
+	// affinity_last, with 1, 2, 4, ... writers and readers, each capped at WNUM and RNUM, for TIME seconds.
+	// The thread arrays are sized for WNUM and RNUM.
+	int backend;
+	int affinity;
+	int level;
+	int first = 1;
+	int writers_max = global_writers;
+	int readers_max = global_readers;
+	intlist_shards_t* shards;
+	printf("[\n");
+	for (backend = backend_first; backend <= backend_last; backend++) {
+		for (affinity = affinity_first; affinity <= affinity_last; affinity++) {
+			global_affinity = affinity;
+			for (level = 1; ; level *= 2) {
+				global_writers = (level < writers_max) ? level : writers_max;
+				global_readers = (level < readers_max) ? level : readers_max;
+				if ((shards = run_prepare(backend)) == NULL) {
+					return -1;
+				}
+				if (run_once(shards,threads_writers,threads_readers,threads_args) != 0) {
+					intlist_shards_destroy(&shards);
+					return -1;
+				}
+				bench_report(stdout,first,backend,shards,threads_args);
+				first = 0;
+				intlist_shards_destroy(&shards);
+				if ((global_writers == writers_max)&&(global_readers == readers_max)) {
+					break;
+				}
+			}
+		}
+	}
+	printf("\n]\n");
+	return 0;
+}
+void dump_values(void* arg, const int* vals, int n) { // Step 8, the intlist_drain() consumer: one line per value to the text_writer_t 'arg'
+	int i;
+	for (i = 0; i < n; i++) {
+		text_writer_int(arg,vals[i]);
+	}
+}
+intlist_node_t* intlist_node_new(void) { // Allocate a node from the pool ('--pool') or with malloc()
+	intlist_node_t* node;
+	if (node_pool.enabled) {
+		return node_pool_alloc();
+	}
+	if ((node = (intlist_node_t *)malloc(sizeof(intlist_node_t))) == NULL) { // The malloc() function return a pointer to the allocated memory that is suitably aligned for any kind of variable. On error, these functions return NULL.
+		fprintf(stderr,F_ERROR_MALLOC_NODE_MSG);
+		exit(EXIT_FAILURE);
+	}
+	return node;
+}
+void intlist_node_release(void* node) { // Give a node from intlist_node_new() back at once
+	if (node_pool.enabled) {
+		node_pool_free(node);
+	} else {
+		free(node);
+	}
+}
+void intlist_node_free(void* node) { // Give an unlinked node back once no snapshot can reach it, 'void*' so it can be a hazard_free_t
+	epoch_retire(node,intlist_node_release);
+}
+int intlist_spin_wait(int* budget, int* count, int min) { // Spin with CPU_RELAX() while '*count' is below 'min', returns 1 if it got there
+	// Adaptive: the budget doubles (up to global_spin_max) when the items came while spinning, and halves (down
+	// to SPIN_MIN) when the caller has to park anyway, so the readers of a list that stays empty soon park at once.
+	int i;
+	int limit = __atomic_load_n(budget,__ATOMIC_RELAXED);
+	if (min <= __atomic_load_n(count,__ATOMIC_RELAXED)) {
+		return 1;
+	}
+	if (global_spin_max < limit) {
+		limit = global_spin_max;
+	}
+	for (i = 0; i < limit; i++) {
+		CPU_RELAX();
+		if (min <= __atomic_load_n(count,__ATOMIC_RELAXED)) {
+			__atomic_store_n(budget,(2*limit < global_spin_max) ? 2*limit : global_spin_max,__ATOMIC_RELAXED);
+			return 1;
+		}
+	}
+	if (0 < limit) {
+		__atomic_store_n(budget,(SPIN_MIN < limit/2) ? limit/2 : SPIN_MIN,__ATOMIC_RELAXED);
+	}
+	return 0;
+}
+int intlist_reserve(intlist* list, int n, int block) { // Bounded lock-free and two-lock backends: take n of the 'capacity' slots before linking n items
+	// Returns 1 once they are taken. If they are not free, returns 0 when 'block' is 0 and parks on 'waitq_full'
+	// otherwise, until there is room or the list is closed (0).
+	int used;
+	int seq;
+	while (1) {
+		used = __atomic_load_n(&(list->slots),__ATOMIC_RELAXED);
+		if (used <= __atomic_load_n(&(list->capacity),__ATOMIC_RELAXED)-n) {
+			if (__atomic_compare_exchange_n(&(list->slots),&used,used+n,1,__ATOMIC_RELAXED,__ATOMIC_RELAXED)) {
+				return 1;
+			}
+			continue;
+		}
+		if ((!block)||(__atomic_load_n(&(list->closed),__ATOMIC_RELAXED) == INTLIST_SHUT_RDWR)) {
+			return 0;
+		}
+		seq = futex_waitq_prepare(&(list->waitq_full));
+		if (__atomic_load_n(&(list->slots),__ATOMIC_SEQ_CST) <= __atomic_load_n(&(list->capacity),__ATOMIC_SEQ_CST)-n) { // Room was made before we announced ourselves
+			futex_waitq_cancel(&(list->waitq_full));
+			continue;
+		}
+		if (__atomic_load_n(&(list->closed),__ATOMIC_SEQ_CST) == INTLIST_SHUT_RDWR) {
+			futex_waitq_cancel(&(list->waitq_full));
+			return 0;
+		}
+		futex_waitq_wait(&(list->waitq_full),seq);
+	}
+}
+void intlist_release(intlist* list, int n) { // Bounded lock-free and two-lock backends: n items left the list, give their slots back
+	if ((__atomic_load_n(&(list->capacity),__ATOMIC_RELAXED) == 0)||(n <= 0)) {
+		return;
+	}
+	__atomic_sub_fetch(&(list->slots),n,__ATOMIC_SEQ_CST);
+	futex_waitq_wake(&(list->waitq_full),n); // A single atomic load if no writer waits
+}
+int mutex_wait_room(intlist* list, int n, int block) { // Called with 'lock' held, waits on 'cond_not_full' until n more items fit under 'capacity'
+	// Returns 1 once they fit, or 0 if the list is closed for pushes, or they do not fit and 'block' is 0.
+	int rc; // Variable for pthread_cond_wait
+	int waits = 0; // Waits of the loop below, for lock_stats_cond_wait()
+	if (list->closed == INTLIST_SHUT_RDWR) {
+		return 0;
+	}
+	while ((0 < list->capacity)&&(list->capacity-list->count < n)) {
+		if ((!block)||(list->closed == INTLIST_SHUT_RDWR)) {
+			return 0;
+		}
+		list->full_waiters += 1;
+		if ((rc = lock_stats_cond_wait(&(list->cond_not_full), &(list->lock), LOCK_SITE_NOT_FULL, LOCK_SITE_LIST, &waits)) != 0) { // Upon successful completion, a value of zero shall be returned; otherwise, an error number shall be returned to indicate the error.
+			fprintf(stderr,F_ERROR_GENERAL_MSG,"pthread_cond_wait()",strerror(rc));
+			exit(EXIT_FAILURE);
+		}
+		list->full_waiters -= 1;
+	}
+	return 1;
+}
+void mutex_room_signal(intlist* list, int freed) { // Called with 'lock' held after 'freed' items left the list, wakes the writers waiting for room
+	int rc; // Variable for pthread_cond_signal & pthread_cond_broadcast
+	if ((list->full_waiters == 0)||(freed <= 0)) {
+		return;
+	}
+	if (freed == 1) { // Room for one item, one writer (all of ours push batches of the same size)
+		if ((rc = lock_stats_cond_signal(&(list->cond_not_full),LOCK_SITE_NOT_FULL)) != 0) { // If successful, the pthread_cond_signal() function shall return zero; otherwise, an error number shall be returned to indicate the error.
+			fprintf(stderr,F_ERROR_GENERAL_MSG,"pthread_cond_signal()",strerror(rc));
+			exit(EXIT_FAILURE);
+		}
+	} else if ((rc = lock_stats_cond_broadcast(&(list->cond_not_full),LOCK_SITE_NOT_FULL)) != 0) { // If successful, the pthread_cond_broadcast() function shall return zero; otherwise, an error number shall be returned to indicate the error.
+		fprintf(stderr,F_ERROR_GENERAL_MSG,"pthread_cond_broadcast()",strerror(rc));
+		exit(EXIT_FAILURE);
+	}
+}
+void lockfree_push_chain(intlist* list, intlist_node_t* first, intlist_node_t* last, int n) { // Michael-Scott enqueue of 'n' nodes linked from 'first' (oldest) to 'last' (newest)
+	// The whole chain is linked with one CAS. If another thread helps before we swing 'lf_tail', it moves
+	// 'lf_tail' to 'first' and later operations walk it along the chain, one node at a time.
+	intlist_node_t* tail;
+	intlist_node_t* next;
+	last->next = NULL;
+	// Count first, a reader may pop the items as soon as the CAS below links them and must not drive 'count'
+	// below zero, where intlist_size() would report its -1 error
+	__atomic_add_fetch(&(list->count),n,__ATOMIC_RELAXED);
+	while (1) {
+		tail = hazard_protect(0,(void **)&(list->lf_tail));
+		next = __atomic_load_n(&(tail->next),__ATOMIC_ACQUIRE);
+		if (tail != __atomic_load_n(&(list->lf_tail),__ATOMIC_ACQUIRE)) {
+			continue;
+		}
+		if (next != NULL) { // 'lf_tail' lags behind, help the other writer and retry
+			__atomic_compare_exchange_n(&(list->lf_tail),&tail,next,0,__ATOMIC_RELEASE,__ATOMIC_RELAXED);
+			continue;
+		}
+		if (__atomic_compare_exchange_n(&(tail->next),&next,first,0,__ATOMIC_SEQ_CST,__ATOMIC_RELAXED)) { // Linked, the items are visible to readers
+			__atomic_compare_exchange_n(&(list->lf_tail),&tail,last,0,__ATOMIC_RELEASE,__ATOMIC_RELAXED); // May fail if someone helped
+			break;
+		}
+	}
+	hazard_clear(0);
+	futex_waitq_wake(&(list->waitq),n); // A single atomic load if no reader waits
+}
+int lockfree_try_pop_tail(intlist* list, int* value) { // Michael-Scott dequeue, returns 0 if the list is empty
+	intlist_node_t* head;
+	intlist_node_t* tail;
+	intlist_node_t* next;
+	while (1) {
+		head = hazard_protect(0,(void **)&(list->lf_head));
+		tail = __atomic_load_n(&(list->lf_tail),__ATOMIC_ACQUIRE);
+		next = __atomic_load_n(&(head->next),__ATOMIC_ACQUIRE);
+		hazard_set(1,next);
+		if (head != __atomic_load_n(&(list->lf_head),__ATOMIC_SEQ_CST)) { // 'next' is only safe while 'head' is still the dummy
+			continue;
+		}
+		if (next == NULL) { // Empty
+			hazard_clear(0);
+			hazard_clear(1);
+			return 0;
+		}
+		if (head == tail) { // 'lf_tail' lags behind, help the writer
+			__atomic_compare_exchange_n(&(list->lf_tail),&tail,next,0,__ATOMIC_RELEASE,__ATOMIC_RELAXED);
+			continue;
+		}
+		*value = next->val; // Read before the CAS, after it 'next' may already be the dummy of another pop
+		if (__atomic_compare_exchange_n(&(list->lf_head),&head,next,0,__ATOMIC_SEQ_CST,__ATOMIC_RELAXED)) { // 'next' is the new dummy
+			break;
+		}
+	}
+	hazard_clear(0);
+	hazard_clear(1);
+	hazard_retire(head,intlist_node_free); // Other readers may still hold the old dummy
+	__atomic_sub_fetch(&(list->count),1,__ATOMIC_RELAXED);
+	intlist_release(list,1);
+	return 1;
+}
+int lockfree_pop_tail(intlist* list) { // Blocking pop, parks on the futex while the list is empty
+	int ret = 0;
+	int seq;
+	while (!lockfree_try_pop_tail(list,&ret)) {
+		if (intlist_spin_wait(&(list->spin),&(list->count),1)) { // An item came while spinning
+			continue;
+		}
+		seq = futex_waitq_prepare(&(list->waitq));
+		if (lockfree_try_pop_tail(list,&ret)) { // An item arrived before we announced ourselves
+			futex_waitq_cancel(&(list->waitq));
+			break;
+		}
+		if (__atomic_load_n(&(list->closed),__ATOMIC_SEQ_CST)) { // Empty and closed
+			futex_waitq_cancel(&(list->waitq));
+			return -1;
+		}
+		futex_waitq_wait(&(list->waitq),seq);
+	}
+	return ret;
+}
+intlist_segment_t* unrolled_segment_new(intlist* list) { // An empty segment, filled from its end by push_head
+	intlist_segment_t* seg = list->seg_spare;
+	if (seg != NULL) {
+		list->seg_spare = NULL;
+	} else if (posix_memalign((void **)&seg,CACHE_LINE,sizeof(intlist_segment_t)) != 0) { // posix_memalign() returns zero on success, or one of the error values listed in the next section on failure.
+		fprintf(stderr,F_ERROR_MALLOC_SEGMENT_MSG);
+		exit(EXIT_FAILURE);
+	}
+	seg->prev = NULL;
+	seg->next = NULL;
+	seg->first = SEGMENT_VALUES;
+	seg->end = SEGMENT_VALUES;
+	return seg;
+}
+void unrolled_segment_free(intlist* list, intlist_segment_t* seg) {
+	if ((list->seg_spare == NULL)&&(!epoch_enabled)) { // A snapshot may still be reading it, reusing it would hand it new values
+		list->seg_spare = seg;
+	} else {
+		epoch_retire(seg,free);
+	}
+}
+void mutex_count_add(intlist* list, int n) { // Called with 'lock' held, the lock based backends change 'count' only here
+	// A relaxed store, not a locked add: only the lock holder writes, intlist_spin_wait(), intlist_size() and
+	// intlist_snapshot() read it without the lock.
+	__atomic_store_n(&(list->count),list->count+n,__ATOMIC_RELAXED);
+}
+void unrolled_push_head(intlist* list, int value) { // Called with 'lock' held
+	intlist_segment_t* seg = list->seg_head;
+	if (seg->first == 0) { // The head segment is full
+		seg = unrolled_segment_new(list);
+		seg->next = list->seg_head;
+		__atomic_store_n(&(list->seg_head->prev),seg,__ATOMIC_RELEASE); // Published to snapshots
+		list->seg_head = seg;
+	}
+	__atomic_store_n(&(seg->vals[seg->first-1]),value,__ATOMIC_RELAXED); // A snapshot may still read the slot, see intlist_snapshot()
+	__atomic_store_n(&(seg->first),seg->first-1,__ATOMIC_RELEASE); // After the value, for snapshots
+	mutex_count_add(list,1);
+}
+void unrolled_segment_reset(intlist_segment_t* seg) { // Called with 'lock' held, the emptied head segment starts over from its end
+	__atomic_store_n(&(seg->first),SEGMENT_VALUES,__ATOMIC_RELEASE);
+	__atomic_store_n(&(seg->end),SEGMENT_VALUES,__ATOMIC_RELEASE);
+}
+int unrolled_pop_tail(intlist* list) { // Called with 'lock' held and 0 < list->count
+	intlist_segment_t* seg = list->seg_tail;
+	int ret;
+	ret = seg->vals[seg->end-1];
+	__atomic_store_n(&(seg->end),seg->end-1,__ATOMIC_RELEASE); // Release, like every store intlist_snapshot() reads without the lock
+	if (seg->first == seg->end) { // Empty
+		if (seg == list->seg_head) { // The only segment, start over from its end
+			unrolled_segment_reset(seg);
+		} else {
+			__atomic_store_n(&(list->seg_tail),seg->prev,__ATOMIC_RELEASE);
+			list->seg_tail->next = NULL;
+			unrolled_segment_free(list,seg);
+		}
+	}
+	mutex_count_add(list,-1);
+	return ret;
+}
+intlist_segment_t* unrolled_remove_last_k(intlist* list, int k) { // Called with 'lock' held, whole segments are unlinked without looking at their values
+	// Returns the unlinked segments, chained through 'next', for the caller to free after it unlocked
+	intlist_segment_t* seg;
+	intlist_segment_t* detached = NULL;
+	int n;
+	while ((0 < k)&&(0 < list->count)) {
+		seg = list->seg_tail;
+		n = seg->end-seg->first;
+		if (k < n) {
+			__atomic_store_n(&(seg->end),seg->end-k,__ATOMIC_RELEASE);
+			mutex_count_add(list,-k);
+			break;
+		}
+		k -= n;
+		mutex_count_add(list,-n);
+		if (seg == list->seg_head) {
+			unrolled_segment_reset(seg);
+		} else {
+			__atomic_store_n(&(list->seg_tail),seg->prev,__ATOMIC_RELEASE);
+			list->seg_tail->next = NULL;
+			if ((list->seg_spare == NULL)&&(!epoch_enabled)) {
+				list->seg_spare = seg;
+			} else {
+				seg->next = detached;
+				detached = seg;
+			}
+		}
+	}
+	return detached;
+}
+intlist_node_t* mutex_detach_last_k(intlist* list, int k, int* removed) { // Called with 'lock' held, unlinks the last k nodes with one splice
+	// Returns the old tail, the '*removed' detached nodes are reached from it through 'prev'. The new tail is
+	// found from the nearer end of the list, so the lock is held for O(min(k, count-k)) steps, not O(1): a node
+	// list has no index to the cut point. The garbage collector trims in slices of GC_SLICE items, which bounds
+	// its pauses at GC_SLICE steps. The nodes themselves are freed by the caller after it unlocked.
+	int i;
+	intlist_node_t* chain = list->tail;
+	intlist_node_t* node;
+	*removed = (k < list->count) ? k : list->count;
+	if (*removed == 0) {
+		return NULL;
+	}
+	if (*removed == list->count) {
+		list->head = list->nil;
+		__atomic_store_n(&(list->tail),list->nil,__ATOMIC_RELEASE); // Release, like every store intlist_snapshot() reads without the lock
+	} else {
+		if (*removed <= list->count-*removed) {
+			node = list->tail;
+			for (i = 0; i < *removed; i++) {
+				node = node->prev;
+			}
+		} else {
+			node = list->head;
+			for (i = 1; i < list->count-*removed; i++) {
+				node = node->next;
+			}
+		}
+		__atomic_store_n(&(list->tail),node,__ATOMIC_RELEASE);
+		node->next = list->nil;
+	}
+	mutex_count_add(list,-*removed);
+	return chain;
+}
+void mutex_link_chain(intlist* list, intlist_node_t* chain_head, intlist_node_t* chain_tail, int n) { // Called with 'lock' held, links n nodes at the head
+	// The chain is linked like the list: 'chain_head' is the newest node, 'next' points to the older ones down to 'chain_tail'.
+	if (list->head != list->nil) { // If the list is not empty (list->count > 0)
+		chain_tail->next = list->head;
+		__atomic_store_n(&(list->head->prev),chain_tail,__ATOMIC_RELEASE); // Release, a snapshot follows 'prev' without the lock
+	} else { // First elements
+		chain_tail->next = list->nil;
+		__atomic_store_n(&(list->tail),chain_tail,__ATOMIC_RELEASE);
+	}
+	list->head = chain_head;
+	mutex_count_add(list,n);
+}
+intlist_node_t* mutex_unlink_tail_n(intlist* list, int* out, int count) { // Called with 'lock' held and 0 < count <= list->count, the oldest count values into out[]
+	// Returns the old tail, the unlinked nodes are reached from it through 'prev'. The caller frees them after it unlocked.
+	int i;
+	intlist_node_t* chain = list->tail;
+	intlist_node_t* node = list->tail;
+	for (i = 0; i < count; i++) {
+		out[i] = node->val;
+		node = node->prev;
+	}
+	if (node == list->nil) { // Everything was taken
+		list->head = list->nil;
+		__atomic_store_n(&(list->tail),list->nil,__ATOMIC_RELEASE); // Release, like every store intlist_snapshot() reads without the lock
+	} else {
+		__atomic_store_n(&(list->tail),node,__ATOMIC_RELEASE);
+		node->next = list->nil;
+	}
+	mutex_count_add(list,-count);
+	return chain;
+}
+fc_request_t* fc_self(intlist* list) { // Combining backend: the calling thread's request of 'list', added to the publication list on first use
+	fc_request_t* req;
+	if (fc_self_id == list->fc_id) {
+		return fc_self_req;
+	}
+	for (req = __atomic_load_n(&(list->fc_requests),__ATOMIC_ACQUIRE); req != NULL; req = req->next) { // A thread that works on several shards
+		if (req->owner == &fc_token) {
+			break;
+		}
+	}
+	if (req == NULL) {
+		if (posix_memalign((void **)&req,CACHE_LINE,sizeof(fc_request_t)) != 0) { // posix_memalign() returns zero on success, or one of the error values listed in the next section on failure.
+			fprintf(stderr,F_ERROR_MALLOC_LIST_MSG);
+			exit(EXIT_FAILURE);
+		}
+		req->state = FC_IDLE;
+		req->owner = &fc_token; // A thread that starts later at the same address takes it over, this one has exited
+		futex_waitq_init(&(req->waitq));
+		req->next = __atomic_load_n(&(list->fc_requests),__ATOMIC_RELAXED);
+		while (!__atomic_compare_exchange_n(&(list->fc_requests),&(req->next),req,1,__ATOMIC_RELEASE,__ATOMIC_RELAXED)) {
+		}
+	}
+	fc_self_req = req;
+	fc_self_id = list->fc_id;
+	return req;
+}
+int fc_serve(intlist* list, fc_request_t* req) { // Called with 'lock' held, runs 'req' like the mutex backend would. 0 if it has to wait
+	int count;
+	if (req->op == FC_PUSH) {
+		if (list->closed == INTLIST_SHUT_RDWR) { // Dropped
+			req->result = 0;
+		} else if ((0 < list->capacity)&&(list->capacity-list->count < req->n)) { // Full
+			if (req->min) {
+				return 0;
+			}
+			req->result = 0;
+		} else {
+			mutex_link_chain(list,req->chain_head,req->chain_tail,req->n);
+			req->result = 1;
+		}
+		return 1;
+	}
+	if ((list->count < req->min)&&(!list->closed)) {
+		return 0;
+	}
+	count = (list->count < req->n) ? list->count : req->n;
+	req->chain_tail = (0 < count) ? mutex_unlink_tail_n(list,req->out,count) : NULL;
+	req->result = ((count == 0)&&(0 < req->min)) ? INTLIST_CLOSED : count; // Only a closed list ends the wait with less than min
+	return 1;
+}
+void fc_combine(intlist* list) { // Called with 'lock' held, serves the published requests of the combining backend
+	// Pushes before pops, so a reader parked on an empty list gets the items of the same pass. The passes after
+	// the first one only look at parked requests, until one serves none of them: whatever can be served is, and
+	// new requests cannot keep the combiner busy forever (their owners are awake and combine themselves).
+	fc_request_t* req;
+	int op;
+	int state;
+	int served = 1;
+	int wanted = FC_PENDING; // The first pass also takes the new requests
+	while (served) {
+		served = 0;
+		for (op = FC_PUSH; op <= FC_POP; op++) {
+			for (req = __atomic_load_n(&(list->fc_requests),__ATOMIC_ACQUIRE); req != NULL; req = req->next) {
+				state = __atomic_load_n(&(req->state),__ATOMIC_ACQUIRE);
+				if (((state != wanted)&&(state != FC_PARKED))||(req->op != op)) {
+					continue;
+				}
+				if (fc_serve(list,req)) {
+					__atomic_store_n(&(req->state),FC_DONE,__ATOMIC_SEQ_CST); // Before the waiters count is read, see futex_waitq.h
+					futex_waitq_wake(&(req->waitq),1);
+					served += 1;
+				} else if (state == FC_PENDING) {
+					__atomic_store_n(&(req->state),FC_PARKED,__ATOMIC_SEQ_CST);
+				}
+			}
+		}
+		wanted = FC_PARKED;
+	}
+}
+int fc_apply(intlist* list, int op, int* out, intlist_node_t* chain_head, intlist_node_t* chain_tail, int n, int min) { // Combining backend: publish a request and return its result once it was served
+	// The thread spins while another thread combines (it may serve this request too), and combines itself once
+	// the lock is free. Popped nodes are freed here, after the combiner unlocked.
+	int i;
+	int rc; // Variable for pthread_mutex_trylock & pthread_mutex_lock & pthread_mutex_unlock
+	int seq;
+	int state;
+	int result;
+	intlist_node_t* node;
+	intlist_node_t* chain;
+	fc_request_t* req = fc_self(list);
+	req->op = op;
+	req->n = n;
+	req->min = min;
+	req->out = out;
+	req->chain_head = chain_head;
+	req->chain_tail = chain_tail;
+	__atomic_store_n(&(req->state),FC_PENDING,__ATOMIC_RELEASE); // Publish
+	while ((state = __atomic_load_n(&(req->state),__ATOMIC_ACQUIRE)) != FC_DONE) {
+		if (state == FC_PARKED) { // Until a pass finds the items (room) for it, or the list is closed
+			seq = futex_waitq_prepare(&(req->waitq));
+			if (__atomic_load_n(&(req->state),__ATOMIC_SEQ_CST) == FC_PARKED) {
+				futex_waitq_wait(&(req->waitq),seq);
+			} else {
+				futex_waitq_cancel(&(req->waitq));
+			}
+			continue;
+		}
+		if ((rc = lock_stats_mutex_trylock(&(list->lock),LOCK_SITE_LIST)) == EBUSY) { // Another thread combines
+			for (i = 0; (i < global_spin_max)&&(__atomic_load_n(&(req->state),__ATOMIC_ACQUIRE) == FC_PENDING); i++) {
+				CPU_RELAX();
+			}
+			if (__atomic_load_n(&(req->state),__ATOMIC_ACQUIRE) != FC_PENDING) {
+				continue;
+			}
+			rc = lock_stats_mutex_lock(&(list->lock),LOCK_SITE_LIST);
+		}
+		if (rc != 0) { // If successful, the pthread_mutex_trylock() and pthread_mutex_lock() functions shall return zero; otherwise, an error number shall be returned to indicate the error.
+			fprintf(stderr,F_ERROR_GENERAL_MSG,"pthread_mutex_lock()",strerror(rc));
+			exit(EXIT_FAILURE);
+		}
+		fc_combine(list);
+		if ((rc = lock_stats_mutex_unlock(&(list->lock),LOCK_SITE_LIST)) != 0) { // If successful, the pthread_mutex_unlock() function shall return zero; otherwise, an error number shall be returned to indicate the error.
+			fprintf(stderr,F_ERROR_GENERAL_MSG,"pthread_mutex_unlock()",strerror(rc));
+			exit(EXIT_FAILURE);
+		}
+	}
+	result = req->result;
+	chain = req->chain_tail;
+	__atomic_store_n(&(req->state),FC_IDLE,__ATOMIC_RELAXED);
+	if (op == FC_POP) { // Free the popped nodes, nobody else can reach them
+		for (i = 0; i < result; i++) {
+			node = chain->prev;
+			intlist_node_free(chain);
+			chain = node;
+		}
+	}
+	return result;
+}
+int lockfree_pop_tail_n(intlist* list, int* out, int max, int min) { // Pops one node at a time, parks while fewer than 'min' were taken
+	int count = 0;
+	int seq;
+	while (count < max) {
+		if (lockfree_try_pop_tail(list,&out[count])) {
+			count += 1;
+			continue;
+		}
+		if (min <= count) {
+			break;
+		}
+		if (intlist_spin_wait(&(list->spin),&(list->count),1)) {
+			continue;
+		}
+		seq = futex_waitq_prepare(&(list->waitq));
+		if (lockfree_try_pop_tail(list,&out[count])) { // An item arrived before we announced ourselves
+			futex_waitq_cancel(&(list->waitq));
+			count += 1;
+			continue;
+		}
+		if (__atomic_load_n(&(list->closed),__ATOMIC_SEQ_CST)) { // Empty and closed, no more items will come
+			futex_waitq_cancel(&(list->waitq));
+			break;
+		}
+		futex_waitq_wait(&(list->waitq),seq);
+	}
+	return ((count == 0)&&(0 < min)) ? INTLIST_CLOSED : count;
+}
+void twolock_push_chain(intlist* list, intlist_node_t* first, intlist_node_t* last, int n) { // Two-lock enqueue of 'n' nodes linked through 'prev' from 'first' (oldest) to 'last' (newest)
+	int rc; // Variable for pthread_mutex_lock & pthread_mutex_unlock
+	last->prev = NULL;
+	// Lock
+	if ((rc = lock_stats_mutex_lock(&(list->head_lock),LOCK_SITE_HEAD)) != 0) { // If successful, the pthread_mutex_lock() function shall return zero; otherwise, an error number shall be returned to indicate the error.
+		fprintf(stderr,F_ERROR_GENERAL_MSG,"pthread_mutex_lock()",strerror(rc));
+		exit(EXIT_FAILURE);
+	}
+	// Count first, so a reader that takes the new items never drives 'count' below zero
+	__atomic_add_fetch(&(list->count),n,__ATOMIC_RELAXED);
+	// Link, on an empty list 'head' is the dummy and a reader may be looking at its 'prev' right now
+	__atomic_store_n(&(list->head->prev),first,__ATOMIC_SEQ_CST);
+	list->head = last;
+	// Unlock
+	if ((rc = lock_stats_mutex_unlock(&(list->head_lock),LOCK_SITE_HEAD)) != 0) { // If successful, the pthread_mutex_unlock() function shall return zero; otherwise, an error number shall be returned to indicate the error.
+		fprintf(stderr,F_ERROR_GENERAL_MSG,"pthread_mutex_unlock()",strerror(rc));
+		exit(EXIT_FAILURE);
+	}
+	futex_waitq_wake(&(list->waitq),n); // A single atomic load if no reader waits
+}
+int twolock_try_pop_n(intlist* list, int* out, int max) { // Two-lock dequeue of up to 'max' items into out[] (NULL to drop them), never blocks
+	// The last node taken becomes the new dummy. The old dummy and the nodes before it are freed after unlocking.
+	int count;
+	int i;
+	int rc; // Variable for pthread_mutex_lock & pthread_mutex_unlock
+	intlist_node_t* dummy;
+	intlist_node_t* node;
+	intlist_node_t* next;
+	// Lock
+	if ((rc = lock_stats_mutex_lock(&(list->tail_lock),LOCK_SITE_TAIL)) != 0) { // If successful, the pthread_mutex_lock() function shall return zero; otherwise, an error number shall be returned to indicate the error.
+		fprintf(stderr,F_ERROR_GENERAL_MSG,"pthread_mutex_lock()",strerror(rc));
+		exit(EXIT_FAILURE);
+	}
+	dummy = list->tail;
+	node = dummy;
+	for (count = 0; count < max; count++) {
+		if ((next = __atomic_load_n(&(node->prev),__ATOMIC_SEQ_CST)) == NULL) { // No newer item
+			break;
+		}
+		if (out != NULL) {
+			out[count] = next->val;
+		}
+		node = next;
+	}
+	__atomic_store_n(&(list->tail),node,__ATOMIC_RELEASE); // intlist_snapshot() reads it without 'tail_lock'
+	// Unlock
+	if ((rc = lock_stats_mutex_unlock(&(list->tail_lock),LOCK_SITE_TAIL)) != 0) { // If successful, the pthread_mutex_unlock() function shall return zero; otherwise, an error number shall be returned to indicate the error.
+		fprintf(stderr,F_ERROR_GENERAL_MSG,"pthread_mutex_unlock()",strerror(rc));
+		exit(EXIT_FAILURE);
+	}
+	if (count == 0) {
+		return 0;
+	}
+	__atomic_sub_fetch(&(list->count),count,__ATOMIC_RELAXED);
+	intlist_release(list,count);
+	// Free, the writers never go back to a node that is not the newest and no reader can reach these anymore
+	for (i = 0; i < count; i++) {
+		next = dummy->prev;
+		intlist_node_free(dummy);
+		dummy = next;
+	}
+	return count;
+}
+int twolock_pop_tail_n(intlist* list, int* out, int max, int min) { // Takes what is there, parks on the futex while fewer than 'min' were taken
+	int count = 0;
+	int n;
+	int seq;
+	while (1) {
+		count += twolock_try_pop_n(list,out+count,max-count);
+		if (min <= count) {
+			break;
+		}
+		if (intlist_spin_wait(&(list->spin),&(list->count),min-count)) {
+			continue;
+		}
+		seq = futex_waitq_prepare(&(list->waitq));
+		if ((n = twolock_try_pop_n(list,out+count,max-count)) != 0) { // Items arrived before we announced ourselves
+			futex_waitq_cancel(&(list->waitq));
+			count += n;
+			continue;
+		}
+		if (__atomic_load_n(&(list->closed),__ATOMIC_SEQ_CST)) { // Empty and closed, no more items will come
+			futex_waitq_cancel(&(list->waitq));
+			break;
+		}
+		futex_waitq_wait(&(list->waitq),seq);
+	}
+	return ((count == 0)&&(0 < min)) ? INTLIST_CLOSED : count;
+}
+void intlist_init(intlist* list) { // init - initialize the list. You may assume the argument is not a previously initialized or destroyed list.
+	intlist_init_backend(list,INTLIST_BACKEND_MUTEX);
+}
+void intlist_init_backend(intlist* list, int backend) { // init_backend - like init, with the implementation behind the list API (INTLIST_BACKEND_*)
+	// You may assume init() and destroy() are called once for each list and not concurrently with any other
+	// calls for that list, i.e., these methods do not need to be thread-safe.
+	if (list == NULL) {
+		return;
+	}
+	// Init variables
+	int rc; // Variable for pthread_mutex_init & pthread_cond_init
+	intlist_node_t* nil;
+	intlist_node_t* dummy = NULL;
+	// Memory allocation
+	if ((nil = (intlist_node_t *)malloc(sizeof(intlist_node_t))) == NULL) { // The malloc() function return a pointer to the allocated memory that is suitably aligned for any kind of variable. On error, these functions return NULL.
+		fprintf(stderr,F_ERROR_MALLOC_NODE_MSG);
+		exit(EXIT_FAILURE);
+	}
+	if ((backend == INTLIST_BACKEND_LOCKFREE)||(backend == INTLIST_BACKEND_TWOLOCK)) {
+		dummy = intlist_node_new(); // Freed like any other node once the first item is popped
+	}
+	// Init the nil element
+	nil->val = 2147483647;
+	nil->prev = NULL;
+	nil->next = NULL;
+	// Init the list element
+	if ((rc = pthread_mutexattr_init(&(list->attr))) != 0) { // Upon successful completion, pthread_mutexattr_init() shall return zero; otherwise, an error number shall be returned to indicate the error.
+		fprintf(stderr,F_ERROR_GENERAL_MSG,"pthread_mutexattr_init()",strerror(rc));
+		exit(EXIT_FAILURE);
+	}
+	if ((rc = pthread_mutexattr_settype(&(list->attr),PTHREAD_MUTEX_RECURSIVE)) != 0) { // If successful, the pthread_mutexattr_settype() function shall return zero; otherwise, an error number shall be returned to indicate the error.
+		fprintf(stderr,F_ERROR_GENERAL_MSG,"pthread_mutexattr_settype()",strerror(rc));
+		exit(EXIT_FAILURE);
+	}
+	if ((rc = pthread_mutex_init(&(list->lock), &(list->attr))) != 0) { // If successful, the pthread_mutex_init() function shall return zero; otherwise, an error number shall be returned to indicate the error.
+		fprintf(stderr,F_ERROR_GENERAL_MSG,"pthread_mutex_init()",strerror(rc));
+		exit(EXIT_FAILURE);
+	}
+	if ((rc = pthread_cond_init(&(list->cond_new_insert), NULL)) != 0) { // If successful, the pthread_cond_init() function shall return zero; otherwise, an error number shall be returned to indicate the error.
+		fprintf(stderr,F_ERROR_GENERAL_MSG,"pthread_cond_init()",strerror(rc));
+		exit(EXIT_FAILURE);
+	}
+	if ((rc = pthread_cond_init(&(list->cond_not_full), NULL)) != 0) { // If successful, the pthread_cond_init() function shall return zero; otherwise, an error number shall be returned to indicate the error.
+		fprintf(stderr,F_ERROR_GENERAL_MSG,"pthread_cond_init()",strerror(rc));
+		exit(EXIT_FAILURE);
+	}
+	if ((rc = pthread_mutex_init(&(list->head_lock), NULL)) != 0) { // If successful, the pthread_mutex_init() function shall return zero; otherwise, an error number shall be returned to indicate the error.
+		fprintf(stderr,F_ERROR_GENERAL_MSG,"pthread_mutex_init()",strerror(rc));
+		exit(EXIT_FAILURE);
+	}
+	if ((rc = pthread_mutex_init(&(list->tail_lock), NULL)) != 0) { // If successful, the pthread_mutex_init() function shall return zero; otherwise, an error number shall be returned to indicate the error.
+		fprintf(stderr,F_ERROR_GENERAL_MSG,"pthread_mutex_init()",strerror(rc));
+		exit(EXIT_FAILURE);
+	}
+	list->backend = backend;
+	list->capacity = 0;
+	list->closed = 0;
+	list->gc_trimming = 0;
+	list->nil = nil;
+	list->count = 0;
+	list->head = list->nil;
+	list->tail = list->nil;
+	list->lf_head = NULL;
+	list->lf_tail = NULL;
+	if (dummy != NULL) {
+		dummy->val = 0;
+		dummy->prev = NULL;
+		dummy->next = NULL;
+	}
+	if (backend == INTLIST_BACKEND_TWOLOCK) {
+		list->head = dummy;
+		list->tail = dummy;
+	} else {
+		list->lf_head = dummy;
+		list->lf_tail = dummy;
+	}
+	futex_waitq_init(&(list->waitq));
+	futex_waitq_init(&(list->waitq_full));
+	list->slots = 0;
+	list->full_waiters = 0;
+	list->waiters = 0;
+	list->batch_waiters = 0;
+	list->spin = SPIN_MIN;
+	list->fc_requests = NULL;
+	list->fc_id = __atomic_add_fetch(&global_fc_ids,1,__ATOMIC_RELAXED);
+	list->seg_spare = NULL;
+	list->seg_head = NULL;
+	list->seg_tail = NULL;
+	if (backend == INTLIST_BACKEND_UNROLLED) {
+		list->seg_head = unrolled_segment_new(list);
+		list->seg_tail = list->seg_head;
+	}
+}
+void intlist_destroy(intlist** list) { // destroy – frees all memory used by the list, including any of its items.
+	// You may assume init() and destroy() are called once for each list and not concurrently with any other
+	// calls for that list, i.e., these methods do not need to be thread-safe.
+	// Replace to "intlist**" as aproved at: http://moodle.tau.ac.il/mod/forum/discuss.php?d=21815
+	intlist* list_friendly = *list;
+	if ((list_friendly == NULL)||(list_friendly->nil == NULL)) {
+		return;
+	}
+	int rc; // Variable for pthread_mutex_destroy & pthread_cond_destroy
+	fc_request_t* req;
+	if (0 < list_friendly->count) { // If the list is not empty
+		intlist_remove_last_k(list_friendly,list_friendly->count); // Remove all items from the list
+	}
+	if (list_friendly->backend == INTLIST_BACKEND_LOCKFREE) {
+		intlist_node_free(list_friendly->lf_head); // The dummy node
+		list_friendly->lf_head = NULL;
+		list_friendly->lf_tail = NULL;
+		hazard_drain(); // No other thread is left, free what the readers retired
+	}
+	if (list_friendly->backend == INTLIST_BACKEND_TWOLOCK) {
+		intlist_node_free(list_friendly->tail); // The dummy node
+	}
+	if (list_friendly->backend == INTLIST_BACKEND_UNROLLED) {
+		free(list_friendly->seg_head); // The list is empty, only one segment is left
+		free(list_friendly->seg_spare);
+		list_friendly->seg_head = NULL;
+		list_friendly->seg_tail = NULL;
+		list_friendly->seg_spare = NULL;
+	}
+	while ((req = list_friendly->fc_requests) != NULL) { // Combining backend
+		list_friendly->fc_requests = req->next;
+		free(req);
+	}
+	free(list_friendly->nil);
+	list_friendly->head = NULL;
+	list_friendly->tail = NULL;
+	list_friendly->nil = NULL;
+	// Destroy
+	if ((rc = pthread_mutex_destroy(&(list_friendly->lock))) != 0) { // If successful, the pthread_mutex_destroy() function shall return zero; otherwise, an error number shall be returned to indicate the error.
+		fprintf(stderr,F_ERROR_GENERAL_MSG,"pthread_mutex_destroy()",strerror(rc));
+		exit(EXIT_FAILURE);
+	}
+	if ((rc = pthread_mutex_destroy(&(list_friendly->head_lock))) != 0) { // If successful, the pthread_mutex_destroy() function shall return zero; otherwise, an error number shall be returned to indicate the error.
+		fprintf(stderr,F_ERROR_GENERAL_MSG,"pthread_mutex_destroy()",strerror(rc));
+		exit(EXIT_FAILURE);
+	}
+	if ((rc = pthread_mutex_destroy(&(list_friendly->tail_lock))) != 0) { // If successful, the pthread_mutex_destroy() function shall return zero; otherwise, an error number shall be returned to indicate the error.
+		fprintf(stderr,F_ERROR_GENERAL_MSG,"pthread_mutex_destroy()",strerror(rc));
+		exit(EXIT_FAILURE);
+	}
+	if ((rc = pthread_mutexattr_destroy(&(list_friendly->attr))) != 0) { // Upon successful completion, pthread_mutexattr_destroy() shall return zero; otherwise, an error number shall be returned to indicate the error.
+		fprintf(stderr,F_ERROR_GENERAL_MSG,"pthread_mutexattr_destroy()",strerror(rc));
+		exit(EXIT_FAILURE);
+	}
+	if ((rc = pthread_cond_destroy(&(list_friendly->cond_new_insert))) != 0) { // If successful, the pthread_cond_destroy() function shall return zero; otherwise, an error number shall be returned to indicate the error.
+		fprintf(stderr,F_ERROR_GENERAL_MSG,"pthread_cond_destroy()",strerror(rc));
+		exit(EXIT_FAILURE);
+	}
+	if ((rc = pthread_cond_destroy(&(list_friendly->cond_not_full))) != 0) { // If successful, the pthread_cond_destroy() function shall return zero; otherwise, an error number shall be returned to indicate the error.
+		fprintf(stderr,F_ERROR_GENERAL_MSG,"pthread_cond_destroy()",strerror(rc));
+		exit(EXIT_FAILURE);
+	}
+	free(*list);
+	*list = NULL;
+	list = NULL;
+}
+void intlist_push_head(intlist* list, int value) { // push_head – receives an int, and adds it to the head of the list.
+	if ((list == NULL)||(list->nil == NULL)) {
+		return;
+	}
+	// Init variables
+	int rc; // Variable for pthread_mutex_lock & pthread_mutex_unlock & pthread_cond_signal
+	intlist_node_t* node = NULL;
+	if (list->backend == INTLIST_BACKEND_COMBINING) { // The node is built and linked by push_head_n
+		intlist_push_head_n(list,&value,1);
+		return;
+	}
+	if ((list->backend == INTLIST_BACKEND_LOCKFREE)||(list->backend == INTLIST_BACKEND_TWOLOCK)) { // Refuse the item once closed, wait for a slot if bounded
+		if ((__atomic_load_n(&(list->closed),__ATOMIC_RELAXED) == INTLIST_SHUT_RDWR)||((list->capacity != 0)&&(!intlist_reserve(list,1,1)))) {
+			return;
+		}
+	}
+	if (list->backend != INTLIST_BACKEND_UNROLLED) { // The unrolled backend stores the value in its head segment
+		// Memory allocation
+		node = intlist_node_new();
+		// Prepare the new node
+		node->val = value;
+		node->prev = list->nil;
+	}
+	if (list->backend == INTLIST_BACKEND_LOCKFREE) {
+		lockfree_push_chain(list,node,node,1);
+		return;
+	}
+	if (list->backend == INTLIST_BACKEND_TWOLOCK) {
+		twolock_push_chain(list,node,node,1);
+		return;
+	}
+	// Lock
+	if ((rc = lock_stats_mutex_lock(&(list->lock),LOCK_SITE_LIST)) != 0) { // If successful, the pthread_mutex_lock() function shall return zero; otherwise, an error number shall be returned to indicate the error.
+		fprintf(stderr,F_ERROR_GENERAL_MSG,"pthread_mutex_lock()",strerror(rc));
+		exit(EXIT_FAILURE);
+	}
+	// Wait for room, if the list is bounded
+	if (!mutex_wait_room(list,1,1)) { // Closed
+		if ((rc = lock_stats_mutex_unlock(&(list->lock),LOCK_SITE_LIST)) != 0) { // If successful, the pthread_mutex_unlock() function shall return zero; otherwise, an error number shall be returned to indicate the error.
+			fprintf(stderr,F_ERROR_GENERAL_MSG,"pthread_mutex_unlock()",strerror(rc));
+			exit(EXIT_FAILURE);
+		}
+		if (node != NULL) {
+			intlist_node_free(node);
+		}
+		return;
+	}
+	// Push to head
+	if (list->backend == INTLIST_BACKEND_UNROLLED) {
+		unrolled_push_head(list,value);
+	} else {
+		mutex_link_chain(list,node,node,1);
+	}
+	// Signal if someone is waiting to pop from the tail (everyone if a pop_tail_n() waits for more than one item)
+	if (0 < list->batch_waiters) {
+		if ((rc = lock_stats_cond_broadcast(&(list->cond_new_insert),LOCK_SITE_INSERT)) != 0) { // If successful, the pthread_cond_broadcast() function shall return zero; otherwise, an error number shall be returned to indicate the error.
+			fprintf(stderr,F_ERROR_GENERAL_MSG,"pthread_cond_broadcast()",strerror(rc));
+			exit(EXIT_FAILURE);
+		}
+	} else if (0 < list->waiters) {
+		if ((rc = lock_stats_cond_signal(&(list->cond_new_insert),LOCK_SITE_INSERT)) != 0) { // If successful, the pthread_cond_signal() function shall return zero; otherwise, an error number shall be returned to indicate the error.
+			fprintf(stderr,F_ERROR_GENERAL_MSG,"pthread_cond_signal()",strerror(rc));
+			exit(EXIT_FAILURE);
+		}
+	}
+	// Unlock
+	if ((rc = lock_stats_mutex_unlock(&(list->lock),LOCK_SITE_LIST)) != 0) { // If successful, the pthread_mutex_unlock() function shall return zero; otherwise, an error number shall be returned to indicate the error.
+		fprintf(stderr,F_ERROR_GENERAL_MSG,"pthread_mutex_unlock()",strerror(rc));
+		exit(EXIT_FAILURE);
+	}
+}
+int intlist_pop_tail(intlist* list) { // pop_tail – removes an item from the tail, and returns its value.
+	// The operation pop_tail() is blocking, i.e., if the list is empty – wait until an item is available, and then pop it.
+	// Returns -1 once the list is closed and empty.
+	if ((list == NULL)||(list->nil == NULL)) {
+		return -1;
+	}
+	// Init variables
+	int ret = 0;
+	if (list->backend == INTLIST_BACKEND_LOCKFREE) {
+		return lockfree_pop_tail(list);
+	}
+	if ((list->backend == INTLIST_BACKEND_TWOLOCK)||(list->backend == INTLIST_BACKEND_COMBINING)) {
+		return (intlist_pop_tail_n(list,&ret,1,1) == INTLIST_CLOSED) ? -1 : ret;
+	}
+	int rc; // Variable for pthread_mutex_lock & pthread_mutex_unlock & pthread_cond_wait
+	int waits = 0; // Waits of the loop below, for lock_stats_cond_wait()
+	// Spin, without the lock, if the list is empty. An item that is a moment away saves a sleep and a wakeup
+	intlist_spin_wait(&(list->spin),&(list->count),1);
+	// Lock
+	if ((rc = lock_stats_mutex_lock(&(list->lock),LOCK_SITE_LIST)) != 0) { // If successful, the pthread_mutex_lock() function shall return zero; otherwise, an error number shall be returned to indicate the error.
+		fprintf(stderr,F_ERROR_GENERAL_MSG,"pthread_mutex_lock()",strerror(rc));
+		exit(EXIT_FAILURE);
+	}
+	// Wait
+	while (list->count == 0) { // If the list is empty
+		if (list->closed) { // ... for good
+			if ((rc = lock_stats_mutex_unlock(&(list->lock),LOCK_SITE_LIST)) != 0) { // If successful, the pthread_mutex_unlock() function shall return zero; otherwise, an error number shall be returned to indicate the error.
+				fprintf(stderr,F_ERROR_GENERAL_MSG,"pthread_mutex_unlock()",strerror(rc));
+				exit(EXIT_FAILURE);
+			}
+			return -1;
+		}
+		list->waiters += 1;
+		if ((rc = lock_stats_cond_wait(&(list->cond_new_insert), &(list->lock), LOCK_SITE_INSERT, LOCK_SITE_LIST, &waits)) != 0) { // Upon successful completion, a value of zero shall be returned; otherwise, an error number shall be returned to indicate the error.
+			fprintf(stderr,F_ERROR_GENERAL_MSG,"pthread_cond_wait()",strerror(rc));
+			exit(EXIT_FAILURE);
+		}
+		list->waiters -= 1;
+	}
+	// Pop the tail
+	if (list->backend == INTLIST_BACKEND_UNROLLED) {
+		ret = unrolled_pop_tail(list);
+	} else {
+		ret = list->tail->val;
+		if (list->head->next == list->nil) { // If there is only one item in the list (list->count == 1)
+			intlist_node_free(list->tail); // Free the old node from the memory
+			list->head = list->nil;
+			__atomic_store_n(&(list->tail),list->nil,__ATOMIC_RELEASE); // Release, like every store intlist_snapshot() reads without the lock
+		} else { // There is more then one item in the list
+			__atomic_store_n(&(list->tail),list->tail->prev,__ATOMIC_RELEASE); // Move the tail pointer
+			intlist_node_free(list->tail->next); // Free the old node from the memory
+			list->tail->next = list->nil; // Delete the link to the old node
+		}
+		mutex_count_add(list,-1);
+	}
+	mutex_room_signal(list,1);
+	// Unlock
+	if ((rc = lock_stats_mutex_unlock(&(list->lock),LOCK_SITE_LIST)) != 0) { // If successful, the pthread_mutex_unlock() function shall return zero; otherwise, an error number shall be returned to indicate the error.
+		fprintf(stderr,F_ERROR_GENERAL_MSG,"pthread_mutex_unlock()",strerror(rc));
+		exit(EXIT_FAILURE);
+	}
+	// Return
+	return ret;
+}
+int push_head_n_block(intlist* list, const int* vals, int n, int block) { // push_head_n and try_push_head_n, n is at most 'capacity' if the list is bounded
+	// Returns 1 once the items were pushed, or 0 if the list is bounded, they do not fit and 'block' is 0.
+	// The nodes are linked into a chain before the lock is taken and the whole chain is spliced in (and the
+	// readers signaled) under one lock acquisition.
+	// Init variables
+	int i;
+	int rc; // Variable for pthread_mutex_lock & pthread_mutex_unlock & pthread_cond_signal & pthread_cond_broadcast
+	intlist_node_t* node;
+	intlist_node_t* chain_head = NULL; // Newest node of the chain
+	intlist_node_t* chain_tail = NULL; // Oldest node of the chain
+	int capacity = __atomic_load_n(&(list->capacity),__ATOMIC_RELAXED);
+	if ((list->backend == INTLIST_BACKEND_LOCKFREE)||(list->backend == INTLIST_BACKEND_TWOLOCK)) { // Refuse the items once closed, take the slots if bounded
+		if ((__atomic_load_n(&(list->closed),__ATOMIC_RELAXED) == INTLIST_SHUT_RDWR)||((capacity != 0)&&(!intlist_reserve(list,n,block)))) {
+			return 0;
+		}
+	} else if ((!block)&&(capacity != 0)&&(capacity-intlist_size(list) < n)) { // Fail early, without building the chain
+		return 0;
+	}
+	if (list->backend != INTLIST_BACKEND_UNROLLED) {
+		for (i = 0; i < n; i++) { // Outside the lock
+			node = intlist_node_new();
+			node->val = vals[i];
+			node->prev = list->nil;
+			if (list->backend == INTLIST_BACKEND_LOCKFREE) { // Linked through 'next' from the oldest to the newest
+				if (chain_head != NULL) {
+					chain_head->next = node;
+				}
+			} else if (list->backend == INTLIST_BACKEND_TWOLOCK) { // Linked through 'prev' from the oldest to the newest
+				if (chain_head != NULL) {
+					chain_head->prev = node;
+				}
+			} else { // Linked like the list, 'next' points to the older node
+				node->next = chain_head;
+				if (chain_head != NULL) {
+					chain_head->prev = node;
+				}
+			}
+			if (chain_tail == NULL) {
+				chain_tail = node;
+			}
+			chain_head = node;
+		}
+	}
+	if (list->backend == INTLIST_BACKEND_LOCKFREE) {
+		lockfree_push_chain(list,chain_tail,chain_head,n);
+		return 1;
+	}
+	if (list->backend == INTLIST_BACKEND_TWOLOCK) {
+		twolock_push_chain(list,chain_tail,chain_head,n);
+		return 1;
+	}
+	if ((list->backend == INTLIST_BACKEND_COMBINING)&&(fc_apply(list,FC_PUSH,NULL,chain_head,chain_tail,n,block))) {
+		return 1;
+	}
+	if (list->backend == INTLIST_BACKEND_COMBINING) { // Closed, or full and 'block' is 0
+		while (chain_head != NULL) { // Linked through 'next' down to the oldest
+			node = chain_head->next;
+			intlist_node_free(chain_head);
+			chain_head = node;
+		}
+		return 0;
+	}
+	// Lock
+	if ((rc = lock_stats_mutex_lock(&(list->lock),LOCK_SITE_LIST)) != 0) { // If successful, the pthread_mutex_lock() function shall return zero; otherwise, an error number shall be returned to indicate the error.
+		fprintf(stderr,F_ERROR_GENERAL_MSG,"pthread_mutex_lock()",strerror(rc));
+		exit(EXIT_FAILURE);
+	}
+	// Wait for room, if the list is bounded
+	if (!mutex_wait_room(list,n,block)) { // Closed, or filled up since the check above
+		if ((rc = lock_stats_mutex_unlock(&(list->lock),LOCK_SITE_LIST)) != 0) { // If successful, the pthread_mutex_unlock() function shall return zero; otherwise, an error number shall be returned to indicate the error.
+			fprintf(stderr,F_ERROR_GENERAL_MSG,"pthread_mutex_unlock()",strerror(rc));
+			exit(EXIT_FAILURE);
+		}
+		while (chain_head != NULL) { // Linked through 'next' down to the oldest
+			node = chain_head->next;
+			intlist_node_free(chain_head);
+			chain_head = node;
+		}
+		return 0;
+	}
+	// Push to head
+	if (list->backend == INTLIST_BACKEND_UNROLLED) {
+		for (i = 0; i < n; i++) {
+			unrolled_push_head(list,vals[i]);
+		}
+	} else {
+		mutex_link_chain(list,chain_head,chain_tail,n);
+	}
+	// Wake up the readers, there may be enough items for more than one
+	if (list->waiters != 0) { // No waiters, no call
+		if ((n == 1)&&(list->batch_waiters == 0)) {
+			if ((rc = lock_stats_cond_signal(&(list->cond_new_insert),LOCK_SITE_INSERT)) != 0) { // If successful, the pthread_cond_signal() function shall return zero; otherwise, an error number shall be returned to indicate the error.
+				fprintf(stderr,F_ERROR_GENERAL_MSG,"pthread_cond_signal()",strerror(rc));
+				exit(EXIT_FAILURE);
+			}
+		} else if ((rc = lock_stats_cond_broadcast(&(list->cond_new_insert),LOCK_SITE_INSERT)) != 0) { // If successful, the pthread_cond_broadcast() function shall return zero; otherwise, an error number shall be returned to indicate the error.
+			fprintf(stderr,F_ERROR_GENERAL_MSG,"pthread_cond_broadcast()",strerror(rc));
+			exit(EXIT_FAILURE);
+		}
+	}
+	// Unlock
+	if ((rc = lock_stats_mutex_unlock(&(list->lock),LOCK_SITE_LIST)) != 0) { // If successful, the pthread_mutex_unlock() function shall return zero; otherwise, an error number shall be returned to indicate the error.
+		fprintf(stderr,F_ERROR_GENERAL_MSG,"pthread_mutex_unlock()",strerror(rc));
+		exit(EXIT_FAILURE);
+	}
+	return 1;
+}
+void intlist_push_head_n(intlist* list, const int* vals, int n) { // push_head_n – adds vals[0], ..., vals[n-1] to the head, vals[n-1] ends up first.
+	// Same result as n calls to push_head. If the list is bounded and full, waits until readers made room for
+	// all n items, a batch larger than the capacity is pushed in parts.
+	if ((list == NULL)||(list->nil == NULL)||(n <= 0)) {
+		return;
+	}
+	int i;
+	int capacity = __atomic_load_n(&(list->capacity),__ATOMIC_RELAXED);
+	if ((0 < capacity)&&(capacity < n)) { // Would never fit at once
+		for (i = 0; i < n; i += capacity) {
+			push_head_n_block(list,vals+i,(capacity < n-i) ? capacity : n-i,1);
+		}
+		return;
+	}
+	push_head_n_block(list,vals,n,1);
+}
+int intlist_try_push_head_n(intlist* list, const int* vals, int n) { // try_push_head_n – like push_head_n, but never waits for room.
+	// Returns 1 if all n items were pushed, and 0 (nothing pushed) if the bounded list has no room for all of them.
+	if ((list == NULL)||(list->nil == NULL)||(n <= 0)) {
+		return 0;
+	}
+	return push_head_n_block(list,vals,n,0);
+}
+int intlist_try_push_head(intlist* list, int value) { // try_push_head – like push_head, returns 0 instead of waiting if the bounded list is full.
+	return intlist_try_push_head_n(list,&value,1);
+}
+void intlist_set_capacity(intlist* list, int capacity) { // set_capacity – bounds the list to 'capacity' items, 0 (the default) is unbounded.
+	// A full bounded list makes push_head wait and try_push_head fail. Whether a list is bounded must be set
+	// before its first push, later the bound can only be changed to another positive one, at any time (INT_MAX
+	// lifts it). Raising it wakes the writers waiting for room, lowering it does not remove any items.
+	int rc; // Variable for pthread_mutex_lock & pthread_mutex_unlock & pthread_cond_broadcast
+	if ((list == NULL)||(list->nil == NULL)||(capacity < 0)) {
+		return;
+	}
+	if ((list->backend == INTLIST_BACKEND_LOCKFREE)||(list->backend == INTLIST_BACKEND_TWOLOCK)) {
+		__atomic_store_n(&(list->capacity),capacity,__ATOMIC_SEQ_CST);
+		futex_waitq_wake(&(list->waitq_full),INT_MAX);
+		return;
+	}
+	// Lock
+	if ((rc = lock_stats_mutex_lock(&(list->lock),LOCK_SITE_LIST)) != 0) { // If successful, the pthread_mutex_lock() function shall return zero; otherwise, an error number shall be returned to indicate the error.
+		fprintf(stderr,F_ERROR_GENERAL_MSG,"pthread_mutex_lock()",strerror(rc));
+		exit(EXIT_FAILURE);
+	}
+	__atomic_store_n(&(list->capacity),capacity,__ATOMIC_RELAXED); // Atomic for the early check of try_push_head_n
+	if (list->backend == INTLIST_BACKEND_COMBINING) { // The parked pushes that fit now
+		fc_combine(list);
+	}
+	if ((0 < list->full_waiters)&&((rc = lock_stats_cond_broadcast(&(list->cond_not_full),LOCK_SITE_NOT_FULL)) != 0)) { // If successful, the pthread_cond_broadcast() function shall return zero; otherwise, an error number shall be returned to indicate the error.
+		fprintf(stderr,F_ERROR_GENERAL_MSG,"pthread_cond_broadcast()",strerror(rc));
+		exit(EXIT_FAILURE);
+	}
+	// Unlock
+	if ((rc = lock_stats_mutex_unlock(&(list->lock),LOCK_SITE_LIST)) != 0) { // If successful, the pthread_mutex_unlock() function shall return zero; otherwise, an error number shall be returned to indicate the error.
+		fprintf(stderr,F_ERROR_GENERAL_MSG,"pthread_mutex_unlock()",strerror(rc));
+		exit(EXIT_FAILURE);
+	}
+}
+void intlist_close(intlist* list, int how) { // close – like shutdown(2), 'how' is INTLIST_SHUT_RD or INTLIST_SHUT_RDWR.
+	// INTLIST_SHUT_RD wakes the readers: blocking pops return what is left, then -1 (pop_tail) or INTLIST_CLOSED
+	// (pop_tail_n), pushes still land. INTLIST_SHUT_RDWR also wakes the writers waiting for room: pushes are
+	// dropped, try_push_head fails. A lock-free or two-lock push that already passed its check may still land.
+	// A list is never opened again, a smaller 'how' than before does nothing.
+	int rc; // Variable for pthread_mutex_lock & pthread_mutex_unlock & pthread_cond_broadcast
+	if ((list == NULL)||(list->nil == NULL)||((how != INTLIST_SHUT_RD)&&(how != INTLIST_SHUT_RDWR))||(how <= list->closed)) {
+		return;
+	}
+	// Lock, a reader of the mutex backends checks 'closed' under it before it waits
+	if ((rc = lock_stats_mutex_lock(&(list->lock),LOCK_SITE_LIST)) != 0) { // If successful, the pthread_mutex_lock() function shall return zero; otherwise, an error number shall be returned to indicate the error.
+		fprintf(stderr,F_ERROR_GENERAL_MSG,"pthread_mutex_lock()",strerror(rc));
+		exit(EXIT_FAILURE);
+	}
+	__atomic_store_n(&(list->closed),how,__ATOMIC_SEQ_CST);
+	if (list->backend == INTLIST_BACKEND_COMBINING) { // Every parked request is served now
+		fc_combine(list);
+	}
+	if ((0 < list->waiters)&&((rc = lock_stats_cond_broadcast(&(list->cond_new_insert),LOCK_SITE_INSERT)) != 0)) { // If successful, the pthread_cond_broadcast() function shall return zero; otherwise, an error number shall be returned to indicate the error.
+		fprintf(stderr,F_ERROR_GENERAL_MSG,"pthread_cond_broadcast()",strerror(rc));
+		exit(EXIT_FAILURE);
+	}
+	if ((0 < list->full_waiters)&&((rc = lock_stats_cond_broadcast(&(list->cond_not_full),LOCK_SITE_NOT_FULL)) != 0)) { // If successful, the pthread_cond_broadcast() function shall return zero; otherwise, an error number shall be returned to indicate the error.
+		fprintf(stderr,F_ERROR_GENERAL_MSG,"pthread_cond_broadcast()",strerror(rc));
+		exit(EXIT_FAILURE);
+	}
+	// Unlock
+	if ((rc = lock_stats_mutex_unlock(&(list->lock),LOCK_SITE_LIST)) != 0) { // If successful, the pthread_mutex_unlock() function shall return zero; otherwise, an error number shall be returned to indicate the error.
+		fprintf(stderr,F_ERROR_GENERAL_MSG,"pthread_mutex_unlock()",strerror(rc));
+		exit(EXIT_FAILURE);
+	}
+	futex_waitq_wake(&(list->waitq),INT_MAX); // Lock-free and two-lock backends
+	futex_waitq_wake(&(list->waitq_full),INT_MAX);
+}
+int intlist_pop_tail_n(intlist* list, int* out, int max, int min) { // pop_tail_n – removes up to max items from the tail into out[], oldest first, and returns how many.
+	// Blocks until at least min items are available (min = 0 never blocks), or returns what is left once the list
+	// is closed: INTLIST_CLOSED if that is nothing and min > 0. The items are unlinked with one walk under one lock
+	// acquisition, and the nodes are freed after the lock is released.
+	if ((list == NULL)||(list->nil == NULL)||(max <= 0)) {
+		return -1;
+	}
+	if (min < 0) {
+		min = 0;
+	} else if (max < min) {
+		min = max;
+	}
+	if (list->backend == INTLIST_BACKEND_LOCKFREE) {
+		return lockfree_pop_tail_n(list,out,max,min);
+	}
+	if (list->backend == INTLIST_BACKEND_TWOLOCK) {
+		return twolock_pop_tail_n(list,out,max,min);
+	}
+	if (list->backend == INTLIST_BACKEND_COMBINING) {
+		if (0 < min) { // Like the mutex backend, a few items away saves a parked request
+			intlist_spin_wait(&(list->spin),&(list->count),min);
+		}
+		return fc_apply(list,FC_POP,out,NULL,NULL,max,min);
+	}
+	// Init variables
+	int count;
+	int i;
+	int rc; // Variable for pthread_mutex_lock & pthread_mutex_unlock & pthread_cond_wait
+	int waits = 0; // Waits of the loop below, for lock_stats_cond_wait()
+	intlist_node_t* node;
+	intlist_node_t* chain = NULL; // The old tail, the detached nodes are reached through 'prev'
+	// Spin, without the lock, while fewer than min items are there
+	if (0 < min) {
+		intlist_spin_wait(&(list->spin),&(list->count),min);
+	}
+	// Lock
+	if ((rc = lock_stats_mutex_lock(&(list->lock),LOCK_SITE_LIST)) != 0) { // If successful, the pthread_mutex_lock() function shall return zero; otherwise, an error number shall be returned to indicate the error.
+		fprintf(stderr,F_ERROR_GENERAL_MSG,"pthread_mutex_lock()",strerror(rc));
+		exit(EXIT_FAILURE);
+	}
+	// Wait, a closed list gets no more items
+	while ((list->count < min)&&(!list->closed)) {
+		list->waiters += 1;
+		if (1 < min) { // A single push must now wake every reader (broadcast), one signal could reach a reader that still waits
+			list->batch_waiters += 1;
+		}
+		if ((rc = lock_stats_cond_wait(&(list->cond_new_insert), &(list->lock), LOCK_SITE_INSERT, LOCK_SITE_LIST, &waits)) != 0) { // Upon successful completion, a value of zero shall be returned; otherwise, an error number shall be returned to indicate the error.
+			fprintf(stderr,F_ERROR_GENERAL_MSG,"pthread_cond_wait()",strerror(rc));
+			exit(EXIT_FAILURE);
+		}
+		list->waiters -= 1;
+		if (1 < min) {
+			list->batch_waiters -= 1;
+		}
+	}
+	// Pop from the tail
+	count = (list->count < max) ? list->count : max;
+	if (list->backend == INTLIST_BACKEND_UNROLLED) {
+		for (i = 0; i < count; i++) {
+			out[i] = unrolled_pop_tail(list);
+		}
+	} else if (0 < count) {
+		chain = mutex_unlink_tail_n(list,out,count);
+	}
+	mutex_room_signal(list,count);
+	// Unlock
+	if ((rc = lock_stats_mutex_unlock(&(list->lock),LOCK_SITE_LIST)) != 0) { // If successful, the pthread_mutex_unlock() function shall return zero; otherwise, an error number shall be returned to indicate the error.
+		fprintf(stderr,F_ERROR_GENERAL_MSG,"pthread_mutex_unlock()",strerror(rc));
+		exit(EXIT_FAILURE);
+	}
+	// Free the detached nodes, nobody else can reach them
+	for (i = 0; i < count && chain != NULL; i++) {
+		node = chain->prev;
+		intlist_node_free(chain);
+		chain = node;
+	}
+	return ((count == 0)&&(0 < min)) ? INTLIST_CLOSED : count; // Only a closed list ends the wait with less than min
+}
+int intlist_remove_last_k(intlist* list, int k) { // remove_last_k – removes k items from the tail, without returning their values. Returns how many it removed.
+	// When remove_last_k() is called with a k larger than the list size, it removes whatever items are in the list and finishes.
+	if ((list == NULL)||(list->nil == NULL)||(k < 0)) { // http://moodle.tau.ac.il/mod/forum/discuss.php?d=22102
+		return -1;
+	}
+	// The lock is held only to splice the items out, they are freed after it is released. A caller that
+	// already holds the lock (it is recursive) makes everyone wait for the frees too.
+	// Init variables
+	int i = 0;
+	int rc; // Variable for pthread_mutex_lock & pthread_mutex_unlock
+	int removed = 0;
+	int count_before;
+	int value;
+	intlist_node_t* chain = NULL;
+	intlist_node_t* node;
+	intlist_segment_t* segments = NULL;
+	intlist_segment_t* seg;
+	// Remove k items
+	if (list->backend == INTLIST_BACKEND_LOCKFREE) {
+		while ((i < k)&&(lockfree_try_pop_tail(list,&value))) { // Never blocks, stops early if the readers emptied the list
+			i += 1;
+		}
+		return i;
+	}
+	if (list->backend == INTLIST_BACKEND_TWOLOCK) {
+		return twolock_try_pop_n(list,NULL,k); // Only 'tail_lock', the writers keep pushing
+	}
+	// Lock
+	if ((rc = lock_stats_mutex_lock(&(list->lock),LOCK_SITE_LIST)) != 0) { // If successful, the pthread_mutex_lock() function shall return zero; otherwise, an error number shall be returned to indicate the error.
+		fprintf(stderr,F_ERROR_GENERAL_MSG,"pthread_mutex_lock()",strerror(rc));
+		exit(EXIT_FAILURE);
+	}
+	// Detach
+	count_before = list->count;
+	if (list->backend == INTLIST_BACKEND_UNROLLED) {
+		segments = unrolled_remove_last_k(list,k);
+	} else {
+		chain = mutex_detach_last_k(list,k,&removed);
+	}
+	removed = count_before-list->count;
+	mutex_room_signal(list,removed);
+	if (list->backend == INTLIST_BACKEND_COMBINING) { // The parked pushes that fit now
+		fc_combine(list);
+	}
+	// Unlock
+	if ((rc = lock_stats_mutex_unlock(&(list->lock),LOCK_SITE_LIST)) != 0) { // If successful, the pthread_mutex_unlock() function shall return zero; otherwise, an error number shall be returned to indicate the error.
+		fprintf(stderr,F_ERROR_GENERAL_MSG,"pthread_mutex_unlock()",strerror(rc));
+		exit(EXIT_FAILURE);
+	}
+	// Free, nobody else can reach the detached items
+	for (i = 0; (i < removed)&&(chain != NULL); i++) { // No chain in the unrolled backend
+		node = chain->prev;
+		intlist_node_free(chain);
+		chain = node;
+	}
+	while (segments != NULL) {
+		seg = segments->next;
+		epoch_retire(segments,free);
+		segments = seg;
+	}
+	return removed;
+}
+int intlist_drain(intlist* list, void (*consume)(void* arg, const int* vals, int n), void* arg) { // drain – removes every item and hands the values to consume(), oldest first, DRAIN_CHUNK at a time. Returns how many.
+	// The lock based backends detach the whole list in O(1) under one lock acquisition, the values are read and
+	// the nodes freed after it is released. The lock-free and two-lock backends pop a chunk at a time instead, so
+	// items pushed meanwhile are drained too.
+	if ((list == NULL)||(list->nil == NULL)) {
+		return -1;
+	}
+	// Init variables
+	int vals[DRAIN_CHUNK];
+	int n = 0;
+	int i;
+	int count = 0;
+	int rc; // Variable for pthread_mutex_lock & pthread_mutex_unlock
+	intlist_node_t* chain = NULL; // The old tail, the detached nodes are reached through 'prev'
+	intlist_node_t* node;
+	intlist_segment_t* segments = NULL; // The old tail segment, the newer ones are reached through 'prev'
+	intlist_segment_t* seg;
+	if (list->backend == INTLIST_BACKEND_LOCKFREE) {
+		while (1) {
+			for (n = 0; (n < DRAIN_CHUNK)&&(lockfree_try_pop_tail(list,&vals[n])); n++) {
+			}
+			if (n == 0) {
+				return count;
+			}
+			consume(arg,vals,n);
+			count += n;
+		}
+	}
+	if (list->backend == INTLIST_BACKEND_TWOLOCK) {
+		while (0 < (n = twolock_try_pop_n(list,vals,DRAIN_CHUNK))) {
+			consume(arg,vals,n);
+			count += n;
+		}
+		return count;
+	}
+	// Lock
+	if ((rc = lock_stats_mutex_lock(&(list->lock),LOCK_SITE_LIST)) != 0) { // If successful, the pthread_mutex_lock() function shall return zero; otherwise, an error number shall be returned to indicate the error.
+		fprintf(stderr,F_ERROR_GENERAL_MSG,"pthread_mutex_lock()",strerror(rc));
+		exit(EXIT_FAILURE);
+	}
+	// Detach
+	count = list->count;
+	if ((count != 0)&&(list->backend == INTLIST_BACKEND_UNROLLED)) { // Every segment goes, the list starts over with an empty one
+		segments = list->seg_tail;
+		list->seg_head = unrolled_segment_new(list);
+		__atomic_store_n(&(list->seg_tail),list->seg_head,__ATOMIC_RELEASE); // Release, like every store intlist_snapshot() reads without the lock
+	} else if (count != 0) {
+		chain = list->tail;
+		list->head = list->nil;
+		__atomic_store_n(&(list->tail),list->nil,__ATOMIC_RELEASE);
+	}
+	mutex_count_add(list,-count);
+	mutex_room_signal(list,count);
+	if (list->backend == INTLIST_BACKEND_COMBINING) { // The parked pushes that fit now
+		fc_combine(list);
+	}
+	// Unlock
+	if ((rc = lock_stats_mutex_unlock(&(list->lock),LOCK_SITE_LIST)) != 0) { // If successful, the pthread_mutex_unlock() function shall return zero; otherwise, an error number shall be returned to indicate the error.
+		fprintf(stderr,F_ERROR_GENERAL_MSG,"pthread_mutex_unlock()",strerror(rc));
+		exit(EXIT_FAILURE);
+	}
+	// Hand over and free, nobody else can reach the detached items
+	for (i = 0; (i < count)&&(chain != NULL); i++) {
+		vals[n++] = chain->val;
+		node = chain->prev;
+		intlist_node_free(chain);
+		chain = node;
+		if (n == DRAIN_CHUNK) {
+			consume(arg,vals,n);
+			n = 0;
+		}
+	}
+	while (segments != NULL) { // Oldest value of a segment at vals[end-1]
+		for (i = segments->end-1; segments->first <= i; i--) {
+			vals[n++] = segments->vals[i];
+			if (n == DRAIN_CHUNK) {
+				consume(arg,vals,n);
+				n = 0;
+			}
+		}
+		seg = segments->prev;
+		epoch_retire(segments,free);
+		segments = seg;
+	}
+	if (0 < n) {
+		consume(arg,vals,n);
+	}
+	return count;
+}
+int intlist_snapshot(intlist* list, void (*consume)(void* arg, const int* vals, int n), void* arg) { // snapshot – hands the values to consume(), oldest first, DRAIN_CHUNK at a time, without removing them. Returns how many.
+	// Never takes a lock, so the writers and readers go on meanwhile. The walk starts at the oldest item and
+	// follows the links towards the newest. A node or segment unlinked under it stays readable until it is done
+	// (epoch.h), and its links still lead back into the list: a removal never changes the links of what it removes.
+	// Weakly consistent: an item that is in the list for the whole call is seen once and in FIFO order, one that
+	// is pushed or popped meanwhile may or may not be. It stops after as many items as the list held when it
+	// started, so busy writers cannot keep it going. In the unrolled backend a segment that empties and starts
+	// over while it is read may show a newer value. Returns -1 unless epoch_init() was called ('--monitor').
+	if ((list == NULL)||(list->nil == NULL)||(!epoch_enabled)) {
+		return -1;
+	}
+	// Init variables
+	int vals[DRAIN_CHUNK];
+	int n = 0;
+	int i;
+	int count = 0;
+	int limit;
+	int first;
+	intlist_node_t* node;
+	intlist_segment_t* seg;
+	epoch_enter();
+	limit = __atomic_load_n(&(list->count),__ATOMIC_ACQUIRE);
+	if (list->backend == INTLIST_BACKEND_UNROLLED) { // Segment by segment, the oldest value of a segment at vals[end-1]
+		for (seg = __atomic_load_n(&(list->seg_tail),__ATOMIC_ACQUIRE); (seg != NULL)&&(count < limit); seg = __atomic_load_n(&(seg->prev),__ATOMIC_ACQUIRE)) {
+			i = __atomic_load_n(&(seg->end),__ATOMIC_ACQUIRE)-1;
+			first = __atomic_load_n(&(seg->first),__ATOMIC_ACQUIRE);
+			for (; (first <= i)&&(count < limit); i--) {
+				vals[n++] = __atomic_load_n(&(seg->vals[i]),__ATOMIC_RELAXED); // A push may reuse the slot meanwhile
+				count += 1;
+				if (n == DRAIN_CHUNK) {
+					consume(arg,vals,n);
+					n = 0;
+				}
+			}
+		}
+	} else {
+		if (list->backend == INTLIST_BACKEND_LOCKFREE) { // Through 'next' from the dummy
+			node = __atomic_load_n(&(list->lf_head),__ATOMIC_ACQUIRE);
+			node = __atomic_load_n(&(node->next),__ATOMIC_ACQUIRE);
+		} else if (list->backend == INTLIST_BACKEND_TWOLOCK) { // Through 'prev' from the dummy
+			node = __atomic_load_n(&(list->tail),__ATOMIC_ACQUIRE);
+			node = __atomic_load_n(&(node->prev),__ATOMIC_ACQUIRE);
+		} else { // Through 'prev' from the tail
+			node = __atomic_load_n(&(list->tail),__ATOMIC_ACQUIRE);
+		}
+		while ((node != NULL)&&(node != list->nil)&&(count < limit)) {
+			vals[n++] = node->val;
+			count += 1;
+			if (n == DRAIN_CHUNK) {
+				consume(arg,vals,n);
+				n = 0;
+			}
+			if (list->backend == INTLIST_BACKEND_LOCKFREE) {
+				node = __atomic_load_n(&(node->next),__ATOMIC_ACQUIRE);
+			} else {
+				node = __atomic_load_n(&(node->prev),__ATOMIC_ACQUIRE);
+			}
+		}
+	}
+	if (0 < n) {
+		consume(arg,vals,n);
+	}
+	epoch_leave();
+	return count;
+}
+int intlist_size(intlist* list) { // size – returns the number of items currently in the list.
+	if ((list == NULL)||(list->nil == NULL)) {
+		return -1;
+	}
+	return __atomic_load_n(&(list->count),__ATOMIC_RELAXED); // Updated without the lock by the lock-free backend
+}
+pthread_mutex_t* intlist_get_mutex(intlist* list) { // get_mutex – returns the mutex used by this list.
+	if ((list == NULL)||(list->nil == NULL)) {
+		return NULL;
+	}
+	return &(list->lock);
+}
+void intlist_shards_init(intlist_shards_t* shards, int count, int backend) { // shards_init – 'count' lists of the backend, allocated CACHE_LINE aligned
+	// Like init, not thread-safe.
+	int i;
+	if ((shards == NULL)||(count < 1)) {
+		return;
+	}
+	if ((shards->lists = (intlist **)malloc(sizeof(intlist *)*count)) == NULL) { // The malloc() function return a pointer to the allocated memory that is suitably aligned for any kind of variable. On error, these functions return NULL.
+		fprintf(stderr,F_ERROR_MALLOC_LIST_MSG);
+		exit(EXIT_FAILURE);
+	}
+	for (i = 0; i < count; i++) {
+		if (posix_memalign((void **)&(shards->lists[i]),CACHE_LINE,sizeof(intlist)) != 0) { // posix_memalign() returns zero on success, or one of the error values listed in the next section on failure.
+			fprintf(stderr,F_ERROR_MALLOC_LIST_MSG);
+			exit(EXIT_FAILURE);
+		}
+		intlist_init_backend(shards->lists[i],backend);
+	}
+	shards->count = count;
+	futex_waitq_init(&(shards->waitq));
+	shards->spin = SPIN_MIN;
+	shards->closed = 0;
+}
+void intlist_shards_destroy(intlist_shards_t** shards) { // shards_destroy – destroys every list and frees the shard set. Like destroy, not thread-safe.
+	intlist_shards_t* shards_friendly = *shards;
+	int i;
+	if ((shards_friendly == NULL)||(shards_friendly->lists == NULL)) {
+		return;
+	}
+	for (i = 0; i < shards_friendly->count; i++) {
+		intlist_destroy(&(shards_friendly->lists[i]));
+	}
+	free(shards_friendly->lists);
+	shards_friendly->lists = NULL;
+	free(*shards);
+	*shards = NULL;
+}
+void intlist_shards_push_head_n(intlist_shards_t* shards, int shard, const int* vals, int n) { // shards_push_head_n – push_head_n to one shard, and wake the readers that found every shard empty
+	if ((n == 1)&&(shards->count == 1)) {
+		intlist_push_head(shards->lists[0],vals[0]);
+		return;
+	}
+	intlist_push_head_n(shards->lists[shard],vals,n);
+	if (1 < shards->count) {
+		futex_waitq_wake(&(shards->waitq),n); // A single atomic load if no reader waits
+	}
+}
+int intlist_shards_try_push_head_n(intlist_shards_t* shards, int shard, const int* vals, int n) { // shards_try_push_head_n – try_push_head_n to one shard, 1 if the items were pushed
+	if (!intlist_try_push_head_n(shards->lists[shard],vals,n)) {
+		return 0;
+	}
+	if (1 < shards->count) {
+		futex_waitq_wake(&(shards->waitq),n); // A single atomic load if no reader waits
+	}
+	return 1;
+}
+int intlist_shards_try_pop_tail_n(intlist_shards_t* shards, int home, int* out, int max, int skip_empty) { // The home shard first, then steal from the next ones, never blocks
+	// 'skip_empty' looks at the size before locking a shard. The re-check after futex_waitq_prepare() must
+	// not trust it, a size read there is not ordered against the writers' wakeup.
+	int i;
+	int count = 0;
+	intlist* list;
+	for (i = 0; (i < shards->count)&&(count < max); i++) {
+		list = shards->lists[(home+i)%shards->count];
+		if ((skip_empty)&&(intlist_size(list) <= 0)) {
+			continue;
+		}
+		count += intlist_pop_tail_n(list,out+count,max-count,0);
+	}
+	return count;
+}
+int intlist_shards_pop_tail_n(intlist_shards_t* shards, int home, int* out, int max, int min) { // shards_pop_tail_n – pop_tail_n starting at shard 'home' (modulo the shard count)
+	// Takes up to max items, from other shards once the home shard is empty, and blocks until at least min
+	// were taken. With a single shard this is pop_tail (max == 1) or pop_tail_n of that list.
+	int count = 0;
+	int n;
+	int seq;
+	if (shards->count == 1) { // pop_tail_n and not pop_tail, which cannot tell a closed list from an item
+		return intlist_pop_tail_n(shards->lists[0],out,max,min);
+	}
+	if (max < min) {
+		min = max;
+	}
+	while (1) {
+		count += intlist_shards_try_pop_tail_n(shards,home % shards->count,out+count,max-count,1);
+		if (min <= count) {
+			break;
+		}
+		if (intlist_spin_wait(&(shards->spin),&(shards->lists[home % shards->count]->count),1)) { // Spins on the home shard only
+			continue;
+		}
+		seq = futex_waitq_prepare(&(shards->waitq));
+		if ((n = intlist_shards_try_pop_tail_n(shards,home % shards->count,out+count,max-count,0)) != 0) { // Items arrived before we announced ourselves
+			futex_waitq_cancel(&(shards->waitq));
+			count += n;
+			continue;
+		}
+		if (__atomic_load_n(&(shards->closed),__ATOMIC_SEQ_CST)) { // Every shard is empty and closed
+			futex_waitq_cancel(&(shards->waitq));
+			break;
+		}
+		futex_waitq_wait(&(shards->waitq),seq);
+	}
+	return ((count == 0)&&(0 < min)) ? INTLIST_CLOSED : count;
+}
+int intlist_shards_size(intlist_shards_t* shards) { // shards_size – the items in all the shards
+	int i;
+	int size = 0;
+	for (i = 0; i < shards->count; i++) {
+		size += intlist_size(shards->lists[i]);
+	}
+	return size;
+}
+void intlist_shards_close(intlist_shards_t* shards, int how) { // shards_close – closes every shard (see intlist_close), then wakes the readers that found them all empty
+	int i;
+	for (i = 0; i < shards->count; i++) {
+		intlist_close(shards->lists[i],how);
+	}
+	__atomic_store_n(&(shards->closed),1,__ATOMIC_SEQ_CST);
+	futex_waitq_wake(&(shards->waitq),INT_MAX);
+}
+pthread_mutex_t* intlist_shards_get_mutex(intlist_shards_t* shards) { // shards_get_mutex – the mutex of the first shard
+	return intlist_get_mutex(shards->lists[0]);
+}
+int main(int argc, char *argv[]) {
+	// General variable
+	char* endptr_WNUM; // strtol for global_writers
+	char* endptr_RNUM; // strtol for global_readers
+	char* endptr_MAX; // strtol for global_max
+	char* endptr_TIME; // strtol for global_time
+	char* endptr_batch; // strtol for '--wbatch=', '--rbatch=' and '--rbatch-min='
+	char* endptr_spin; // strtol for '--spin=' and '--monitor='
+	long spin;
+	char* operands[4]; // <WNUM> <RNUM> <MAX> <TIME>
+	long batch_size;
+	int operands_count = 0;
+	int i; // tmp loop var
+	int tmpListSize = 0;
+	text_writer_t dump; // Step 8, the items bypass printf()
+	int shard;
+	int rc; // Variable for pthread_attr_init & pthread_cond_init & node_pool_init
+	int backend_given = 0; // '--backend=' was given, '--bench' only runs that backend
+	int affinity_all = 0; // '--affinity=all', '--bench' runs every placement
+	intlist_shards_t* shards = NULL;
+	thread_args_t* threads_args = NULL; // The writers' followed by the readers'
+	pthread_t* threads_writers;
+	pthread_t* threads_readers;
+	// Check correct call structure
+	if (sysconf(_SC_NPROCESSORS_ONLN) < 2) { // Spinning only delays the writer the reader waits for
+		global_spin_max = 0;
+	}
+	for (i=1;i<argc;i++) {
+		if (strncmp(argv[i],"--backend=",10) == 0) {
+			for (global_backend = INTLIST_BACKENDS_COUNT-1; 0 <= global_backend; global_backend--) {
+				if (strcmp(argv[i]+10,backend_names[global_backend]) == 0) {
+					break;
+				}
+			}
+			if (global_backend < 0) {
+				printf(USAGE_OPTION_INVALID_MSG,argv[i],argv[0]);
+				return EXIT_FAILURE;
+			}
+			backend_given = 1;
+		} else if ((strncmp(argv[i],"--wbatch=",9) == 0)||(strncmp(argv[i],"--rbatch=",9) == 0)||(strncmp(argv[i],"--rbatch-min=",13) == 0)) {
+			batch_size = strtol(strchr(argv[i],'=')+1, &endptr_batch, 10);
+			if ((*endptr_batch != '\0')||(endptr_batch == strchr(argv[i],'=')+1)||(batch_size < 1)||(BATCH_MAX < batch_size)) {
+				printf(USAGE_OPTION_INVALID_MSG,argv[i],argv[0]);
+				return EXIT_FAILURE;
+			}
+			if (argv[i][2] == 'w') {
+				global_writers_batch = batch_size;
+			} else if (argv[i][8] == '=') {
+				global_readers_batch = batch_size;
+			} else {
+				global_readers_batch_min = batch_size;
+			}
+		} else if (strcmp(argv[i],"--pool") == 0) {
+			global_pool = 1;
+		} else if (strcmp(argv[i],"--pool=huge") == 0) {
+			global_pool = 2;
+		} else if (strcmp(argv[i],"--sharded") == 0) {
+			global_sharded = 1;
+		} else if (strcmp(argv[i],"--bounded") == 0) {
+			global_bounded = 1;
+		} else if (strcmp(argv[i],"--bounded=try") == 0) {
+			global_bounded = 2;
+		} else if (strcmp(argv[i],"--bench") == 0) {
+			global_bench = 1;
+		} else if (strcmp(argv[i],"--lockstats") == 0) {
+			lock_stats_enabled = 1;
+		} else if (strcmp(argv[i],"--affinity=all") == 0) {
+			affinity_all = 1;
+		} else if (strncmp(argv[i],"--affinity=",11) == 0) {
+			for (global_affinity = AFFINITY_POLICIES-1; 0 <= global_affinity; global_affinity--) {
+				if (strcmp(argv[i]+11,affinity_names[global_affinity]) == 0) {
+					break;
+				}
+			}
+			if (global_affinity < 0) {
+				printf(USAGE_OPTION_INVALID_MSG,argv[i],argv[0]);
+				return EXIT_FAILURE;
+			}
+			affinity_all = 0;
+		} else if (strncmp(argv[i],"--spin=",7) == 0) {
+			spin = strtol(argv[i]+7, &endptr_spin, 10);
+			if ((*endptr_spin != '\0')||(endptr_spin == argv[i]+7)||(spin < 0)||(SPIN_LIMIT < spin)) {
+				printf(USAGE_OPTION_INVALID_MSG,argv[i],argv[0]);
+				return EXIT_FAILURE;
+			}
+			global_spin_max = spin;
+		} else if (strncmp(argv[i],"--monitor=",10) == 0) {
+			spin = strtol(argv[i]+10, &endptr_spin, 10);
+			if ((*endptr_spin != '\0')||(endptr_spin == argv[i]+10)||(spin < 1)||(MONITOR_MAX < spin)) {
+				printf(USAGE_OPTION_INVALID_MSG,argv[i],argv[0]);
+				return EXIT_FAILURE;
+			}
+			global_monitor = spin;
+		} else if (operands_count < 4) {
+			operands[operands_count] = argv[i];
+			operands_count += 1;
+		} else {
+			operands_count += 1; // Too many operands
+		}
+	}
+	if (operands_count != 4) {
+		if (operands_count < 4) {
+			printf(USAGE_OPERANDS_MISSING_MSG,argv[0]);
+		} else {
+			printf(USAGE_OPERANDS_SURPLUS_MSG,argv[0]);
+		}
+		return EXIT_FAILURE;
+	}
+	global_writers = strtol(operands[0], &endptr_WNUM, 10); // If an underflow occurs. strtol() returns LONG_MIN. If an overflow occurs, strtol() returns LONG_MAX. In both cases, errno is set to ERANGE.
+	if ((errno == ERANGE && (global_writers == LONG_MAX || global_writers == LONG_MIN)) || (errno != 0 && global_writers == 0)) {
+		fprintf(stderr,F_ERROR_STRTOL_MSG,strerror(errno));
+		return errno;
+	}
+	global_readers = strtol(operands[1], &endptr_RNUM, 10); // If an underflow occurs. strtol() returns LONG_MIN. If an overflow occurs, strtol() returns LONG_MAX. In both cases, errno is set to ERANGE.
+	if ((errno == ERANGE && (global_readers == LONG_MAX || global_readers == LONG_MIN)) || (errno != 0 && global_readers == 0)) {
+		fprintf(stderr,F_ERROR_STRTOL_MSG,strerror(errno));
+		return errno;
+	}
+	global_max = strtol(operands[2], &endptr_MAX, 10); // If an underflow occurs. strtol() returns LONG_MIN. If an overflow occurs, strtol() returns LONG_MAX. In both cases, errno is set to ERANGE.
+	if ((errno == ERANGE && (global_max == LONG_MAX || global_max == LONG_MIN)) || (errno != 0 && global_max == 0)) {
+		fprintf(stderr,F_ERROR_STRTOL_MSG,strerror(errno));
+		return errno;
+	}
+	global_time = strtol(operands[3], &endptr_TIME, 10); // If an underflow occurs. strtol() returns LONG_MIN. If an overflow occurs, strtol() returns LONG_MAX. In both cases, errno is set to ERANGE.
+	if ((errno == ERANGE && (global_time == LONG_MAX || global_time == LONG_MIN)) || (errno != 0 && global_time == 0)) {
+		fprintf(stderr,F_ERROR_STRTOL_MSG,strerror(errno));
+		return errno;
+	}
+	if ( (endptr_WNUM == operands[0])||(endptr_RNUM == operands[1])||(endptr_MAX == operands[2])||(endptr_TIME == operands[3]) ) { // Empty string
+		printf(USAGE_OPERANDS_MISSING_MSG,argv[0]);
+		return EXIT_FAILURE;
+	}
+	if ( (global_writers < 1)||(global_readers < 1)||(global_max < 1)||(global_time < 1) ) { // Not positive
+		printf(USAGE_NUM_LESS_THEN_ONE_MSG);
+		return EXIT_FAILURE;
+	}
+	// Init threads array
+	if ((threads_writers = (pthread_t *)malloc(sizeof(pthread_t)*global_writers)) == NULL) { // The malloc() function return a pointer to the allocated memory that is suitably aligned for any kind of variable. On error, these functions return NULL.
+		fprintf(stderr,F_ERROR_MALLOC_LIST_MSG);
+		return EXIT_FAILURE;
+	}
+	if ((threads_readers = (pthread_t *)malloc(sizeof(pthread_t)*global_readers)) == NULL) { // The malloc() function return a pointer to the allocated memory that is suitably aligned for any kind of variable. On error, these functions return NULL.
+		fprintf(stderr,F_ERROR_MALLOC_THREADS_MSG);
+		return EXIT_FAILURE;
+	}
+	if ((threads_args = (thread_args_t *)malloc(sizeof(thread_args_t)*(global_writers+global_readers))) == NULL) { // The malloc() function return a pointer to the allocated memory that is suitably aligned for any kind of variable. On error, these functions return NULL.
+		fprintf(stderr,F_ERROR_MALLOC_THREADS_MSG);
+		return EXIT_FAILURE;
+	}
+	// Init the attr var
+	if ((rc = pthread_attr_init(&attr)) != 0) { // On success, these functions return 0; on error, they return a nonzero error number.
+		fprintf(stderr,F_ERROR_GENERAL_MSG,"pthread_attr_init()",strerror(rc));
+		return program_end(-1,shards,threads_writers,threads_readers,threads_args);
+	}
+	if ((rc = pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_JOINABLE)) != 0) { // On success, pthread_join() returns 0; on error, it returns an error number.
+		fprintf(stderr,F_ERROR_GENERAL_MSG,"pthread_attr_setdetachstate()",strerror(rc));
+		return program_end(-1,shards,threads_writers,threads_readers,threads_args);
+	}
+	if ((global_affinity != AFFINITY_NONE)||(affinity_all)) { // '--affinity=', the same attributes plus a CPU set per thread
+		cpu_topology_load(&global_topology);
+		if ((global_cpu_order = (int *)malloc(sizeof(int)*global_topology.count)) == NULL) { // The malloc() function return a pointer to the allocated memory that is suitably aligned for any kind of variable. On error, these functions return NULL.
+			fprintf(stderr,F_ERROR_MALLOC_THREADS_MSG);
+			cpu_topology_destroy(&global_topology);
+			return program_end(-1,shards,threads_writers,threads_readers,threads_args);
+		}
+		if (((rc = pthread_attr_init(&attr_placed)) != 0)||((rc = pthread_attr_setdetachstate(&attr_placed, PTHREAD_CREATE_JOINABLE)) != 0)) { // On success, these functions return 0; on error, they return a nonzero error number.
+			fprintf(stderr,F_ERROR_GENERAL_MSG,"pthread_attr_init()",strerror(rc));
+			return program_end(-1,shards,threads_writers,threads_readers,threads_args);
+		}
+	}
+	if ((global_pool)&&((rc = node_pool_init(sizeof(intlist_node_t),global_pool == 2)) != 0)) {
+		fprintf(stderr,F_ERROR_GENERAL_MSG,"node_pool_init()",strerror(rc));
+		return program_end(-1,shards,threads_writers,threads_readers,threads_args);
+	}
+	if (global_monitor) { // '--monitor=', before any node is freed
+		epoch_init();
+	}
+	if (lock_stats_enabled) { // '--lockstats', SIGUSR1 is blocked here and inherited by every thread created below
+		sigemptyset(&lock_stats_signals);
+		sigaddset(&lock_stats_signals,SIGUSR1);
+		if ((rc = pthread_sigmask(SIG_BLOCK,&lock_stats_signals,NULL)) != 0) { // On success, pthread_sigmask() returns 0; on error, it returns an error number.
+			fprintf(stderr,F_ERROR_GENERAL_MSG,"pthread_sigmask()",strerror(rc));
+			return program_end(-1,shards,threads_writers,threads_readers,threads_args);
+		}
+		if ((rc = pthread_create(&thread_lock_stats, &attr, thrd_lock_stats, NULL)) != 0) { // On success, pthread_create() returns 0; on error, it returns an error number, and the contents of *thread are undefined.
+			fprintf(stderr,F_ERROR_GENERAL_MSG,"lock statistics pthread_create()",strerror(rc));
+			return program_end(-1,shards,threads_writers,threads_readers,threads_args);
+		}
+		global_lock_stats = 1;
+	}
+	// 2. Create a condition variable for the garbage collector. (different than the condition variable used internally by the list's pop_tail operation)
+	if ((rc = pthread_cond_init(&count_garbage_collector, NULL)) != 0) { // If successful, the pthread_cond_init() function shall return zero; otherwise, an error number shall be returned to indicate the error.
+		fprintf(stderr,F_ERROR_GENERAL_MSG,"pthread_cond_init()",strerror(rc));
+		return program_end(-1,shards,threads_writers,threads_readers,threads_args);
+	}
+	if ((rc = pthread_mutex_init(&gc_lock, NULL)) != 0) { // If successful, the pthread_mutex_init() function shall return zero; otherwise, an error number shall be returned to indicate the error.
+		fprintf(stderr,F_ERROR_GENERAL_MSG,"pthread_mutex_init()",strerror(rc));
+		return program_end(-1,shards,threads_writers,threads_readers,threads_args);
+	}
+	if (global_bench) { // '--bench', steps 1 to 7 for every backend ('--backend=' picks one) and thread count
+		rc = bench_matrix(backend_given ? global_backend : 0,backend_given ? global_backend : INTLIST_BACKENDS_COUNT-1,affinity_all ? 0 : global_affinity,affinity_all ? AFFINITY_POLICIES-1 : global_affinity,threads_writers,threads_readers,threads_args);
+		return program_end(rc,shards,threads_writers,threads_readers,threads_args);
+	}
+	// 1. Define and initialize a global doubly-linked list of integers.
+	//    In sharded mode ('--sharded') one list per writer.
+	if ((shards = run_prepare(global_backend)) == NULL) {
+		return program_end(-1,shards,threads_writers,threads_readers,threads_args);
+	}
+	// 3. - 7.
+	if (run_once(shards,threads_writers,threads_readers,threads_args) != 0) {
+		return program_end(-1,shards,threads_writers,threads_readers,threads_args);
+	}
+	// 8. Print the size of the list as well as all items within it.
+	tmpListSize = intlist_shards_size(shards);
+	fflush(stdout); // The items are written to its descriptor directly
+	text_writer_init(&dump,STDOUT_FILENO);
+	for (shard=0;shard<shards->count;shard++) { // Shard by shard in sharded mode, each detached at once
+		intlist_drain(shards->lists[shard],dump_values,&dump);
+	}
+	text_writer_destroy(&dump);
+	printf(LIST_SIZE_MSG,tmpListSize);
+	if (node_pool.enabled) {
+		node_pool_print(stdout);
+	}
+	// 9. Cleanup. Exit gracefully
+	return program_end(0,shards,threads_writers,threads_readers,threads_args);
+}
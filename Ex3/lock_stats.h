@@ -0,0 +1,224 @@
+#ifndef LOCK_STATS_H
+#define LOCK_STATS_H
+
+// Optional instrumentation of mutexes and condition variables. The wrappers take the same arguments as the
+// pthread functions plus a site, a small integer that names the lock or condition variable (the caller
+// keeps the names), and return what the pthread function returned. While 'lock_stats_enabled' is 0 a
+// wrapper is one predictable branch in front of the pthread call. Set it before the threads start.
+// When enabled, every thread counts into its own record, so the hot path writes only thread-local lines:
+//   lock   - acquisitions, contended ones (trylock failed) with their wait time, and hold time (outermost
+//            lock to the matching unlock; a condition wait ends the hold and the wakeup starts a new one).
+//            A successful lock_stats_mutex_trylock() is an acquisition, a failed one is not counted.
+//   cond   - waits, time waiting, signals, broadcasts and spurious wakeups (a wait that follows a wakeup
+//            whose caller found its predicate still false, see lock_stats_cond_wait)
+// The records of exited threads are kept, lock_stats_print() sums them all and may run at any time.
+
+#include <errno.h> // EBUSY
+#include <pthread.h> // pthread_mutex_t, pthread_cond_t, pthread_mutex_lock, pthread_mutex_trylock, pthread_mutex_unlock, pthread_cond_wait, pthread_cond_signal, pthread_cond_broadcast
+#include <stdio.h> // FILE, fprintf, stderr
+#include <stdlib.h> // EXIT_FAILURE, exit, calloc, free
+#include <time.h> // CLOCK_MONOTONIC, struct timespec, clock_gettime
+
+#define LOCK_STATS_SITES_MAX	8
+
+// Define printing strings
+#define LOCK_STATS_LOCK_MSG		"Lock %s: %ld acquisitions, %ld contended (%.2f%%), waited %.3f ms (max %.3f ms), held %.3f ms (max %.3f ms)\n"
+#define LOCK_STATS_COND_MSG		"Cond %s: %ld waits (%.3f ms), %ld spurious wakeups, %ld signals, %ld broadcasts\n"
+#define LOCK_STATS_ERROR_MALLOC_MSG	"[Error] Failed to allocate memory to lock statistics.\n"
+
+typedef struct lock_stats_site {
+	long acquires;
+	long contended;
+	long wait_ns; // Time in pthread_mutex_lock() after a failed trylock
+	long wait_max_ns;
+	long hold_ns;
+	long hold_max_ns;
+	long cond_waits;
+	long cond_wait_ns;
+	long spurious;
+	long signals;
+	long broadcasts;
+	int depth; // Recursive locks held by the owner thread, the hold is measured at depth 0 -> 1 -> 0
+	struct timespec hold_start;
+} lock_stats_site_t;
+typedef struct lock_stats_record {
+	lock_stats_site_t sites[LOCK_STATS_SITES_MAX];
+	struct lock_stats_record *next; // Records are only added, lock_stats_destroy() frees them
+} lock_stats_record_t;
+
+static int lock_stats_enabled = 0;
+static lock_stats_record_t *lock_stats_records = NULL;
+static __thread lock_stats_record_t *lock_stats_record = NULL;
+
+static inline long lock_stats_ns(const struct timespec *t_start, const struct timespec *t_end) {
+	return (t_end->tv_sec-t_start->tv_sec)*1000000000L + (t_end->tv_nsec-t_start->tv_nsec);
+}
+// lock_stats_add - add to a counter of the own record. A relaxed store, not a locked add: only the owner writes,
+// lock_stats_print() may read at the same time.
+static inline void lock_stats_add(long *counter, long value) {
+	__atomic_store_n(counter,__atomic_load_n(counter,__ATOMIC_RELAXED)+value,__ATOMIC_RELAXED);
+}
+static inline void lock_stats_max(long *counter, long value) {
+	if (__atomic_load_n(counter,__ATOMIC_RELAXED) < value) {
+		__atomic_store_n(counter,value,__ATOMIC_RELAXED);
+	}
+}
+static inline lock_stats_site_t *lock_stats_site(int site) {
+	lock_stats_record_t *rec = lock_stats_record;
+	if (rec == NULL) {
+		if ((rec = (lock_stats_record_t *)calloc(1,sizeof(lock_stats_record_t))) == NULL) { // The calloc() function return a pointer to the allocated memory that is suitably aligned for any kind of variable. On error, these functions return NULL.
+			fprintf(stderr,LOCK_STATS_ERROR_MALLOC_MSG);
+			exit(EXIT_FAILURE);
+		}
+		rec->next = __atomic_load_n(&lock_stats_records,__ATOMIC_RELAXED);
+		while (!__atomic_compare_exchange_n(&lock_stats_records,&rec->next,rec,1,__ATOMIC_RELEASE,__ATOMIC_RELAXED)) {
+		}
+		lock_stats_record = rec;
+	}
+	return &rec->sites[site];
+}
+static inline void lock_stats_hold_begin(lock_stats_site_t *s) {
+	clock_gettime(CLOCK_MONOTONIC,&s->hold_start);
+}
+static inline void lock_stats_hold_end(lock_stats_site_t *s) {
+	struct timespec t_end;
+	long hold;
+	clock_gettime(CLOCK_MONOTONIC,&t_end);
+	hold = lock_stats_ns(&s->hold_start,&t_end);
+	lock_stats_add(&s->hold_ns,hold);
+	lock_stats_max(&s->hold_max_ns,hold);
+}
+static inline int lock_stats_mutex_lock(pthread_mutex_t *mutex, int site) {
+	lock_stats_site_t *s;
+	struct timespec t_start,t_end;
+	long wait;
+	int rc;
+	if (!lock_stats_enabled) {
+		return pthread_mutex_lock(mutex);
+	}
+	s = lock_stats_site(site);
+	if ((rc = pthread_mutex_trylock(mutex)) == EBUSY) { // Contended, time the wait
+		clock_gettime(CLOCK_MONOTONIC,&t_start);
+		if ((rc = pthread_mutex_lock(mutex)) != 0) {
+			return rc;
+		}
+		clock_gettime(CLOCK_MONOTONIC,&t_end);
+		wait = lock_stats_ns(&t_start,&t_end);
+		lock_stats_add(&s->contended,1);
+		lock_stats_add(&s->wait_ns,wait);
+		lock_stats_max(&s->wait_max_ns,wait);
+	} else if (rc != 0) {
+		return rc;
+	}
+	lock_stats_add(&s->acquires,1);
+	if (s->depth++ == 0) {
+		lock_stats_hold_begin(s);
+	}
+	return 0;
+}
+static inline int lock_stats_mutex_trylock(pthread_mutex_t *mutex, int site) {
+	lock_stats_site_t *s;
+	int rc;
+	if (((rc = pthread_mutex_trylock(mutex)) != 0)||(!lock_stats_enabled)) {
+		return rc;
+	}
+	s = lock_stats_site(site);
+	lock_stats_add(&s->acquires,1);
+	if (s->depth++ == 0) {
+		lock_stats_hold_begin(s);
+	}
+	return 0;
+}
+static inline int lock_stats_mutex_unlock(pthread_mutex_t *mutex, int site) {
+	lock_stats_site_t *s;
+	if (lock_stats_enabled) {
+		s = lock_stats_site(site);
+		if ((0 < s->depth)&&(--s->depth == 0)) {
+			lock_stats_hold_end(s);
+		}
+	}
+	return pthread_mutex_unlock(mutex);
+}
+// lock_stats_cond_wait - pthread_cond_wait() on 'cond' (site 'cond_site') and 'mutex' (site 'mutex_site').
+// '*waits' counts the waits of one predicate loop, the caller sets it to 0 before the loop. Every wait after
+// the first one in a loop means the previous wakeup was spurious (or another thread took what it was for).
+static inline int lock_stats_cond_wait(pthread_cond_t *cond, pthread_mutex_t *mutex, int cond_site, int mutex_site, int *waits) {
+	lock_stats_site_t *c;
+	lock_stats_site_t *m;
+	struct timespec t_start,t_end;
+	int rc;
+	if (!lock_stats_enabled) {
+		return pthread_cond_wait(cond,mutex);
+	}
+	c = lock_stats_site(cond_site);
+	m = lock_stats_site(mutex_site);
+	if (0 < *waits) {
+		lock_stats_add(&c->spurious,1);
+	}
+	*waits += 1;
+	lock_stats_add(&c->cond_waits,1);
+	if (0 < m->depth) { // The mutex is released while waiting
+		lock_stats_hold_end(m);
+	}
+	clock_gettime(CLOCK_MONOTONIC,&t_start);
+	rc = pthread_cond_wait(cond,mutex);
+	clock_gettime(CLOCK_MONOTONIC,&t_end);
+	lock_stats_add(&c->cond_wait_ns,lock_stats_ns(&t_start,&t_end));
+	if (0 < m->depth) {
+		m->hold_start = t_end;
+	}
+	return rc;
+}
+static inline int lock_stats_cond_signal(pthread_cond_t *cond, int site) {
+	if (lock_stats_enabled) {
+		lock_stats_add(&lock_stats_site(site)->signals,1);
+	}
+	return pthread_cond_signal(cond);
+}
+static inline int lock_stats_cond_broadcast(pthread_cond_t *cond, int site) {
+	if (lock_stats_enabled) {
+		lock_stats_add(&lock_stats_site(site)->broadcasts,1);
+	}
+	return pthread_cond_broadcast(cond);
+}
+// lock_stats_print - one line per site that was used, summed over every thread. 'names' has 'sites' entries.
+static inline void lock_stats_print(FILE *stream, const char *const *names, int sites) {
+	lock_stats_record_t *rec;
+	lock_stats_site_t sum;
+	lock_stats_site_t *s;
+	int i;
+	for (i = 0; i < sites; i++) {
+		sum = (lock_stats_site_t){0};
+		for (rec = __atomic_load_n(&lock_stats_records,__ATOMIC_ACQUIRE); rec != NULL; rec = rec->next) {
+			s = &rec->sites[i];
+			sum.acquires += __atomic_load_n(&s->acquires,__ATOMIC_RELAXED);
+			sum.contended += __atomic_load_n(&s->contended,__ATOMIC_RELAXED);
+			sum.wait_ns += __atomic_load_n(&s->wait_ns,__ATOMIC_RELAXED);
+			sum.hold_ns += __atomic_load_n(&s->hold_ns,__ATOMIC_RELAXED);
+			sum.cond_waits += __atomic_load_n(&s->cond_waits,__ATOMIC_RELAXED);
+			sum.cond_wait_ns += __atomic_load_n(&s->cond_wait_ns,__ATOMIC_RELAXED);
+			sum.spurious += __atomic_load_n(&s->spurious,__ATOMIC_RELAXED);
+			sum.signals += __atomic_load_n(&s->signals,__ATOMIC_RELAXED);
+			sum.broadcasts += __atomic_load_n(&s->broadcasts,__ATOMIC_RELAXED);
+			lock_stats_max(&sum.wait_max_ns,__atomic_load_n(&s->wait_max_ns,__ATOMIC_RELAXED));
+			lock_stats_max(&sum.hold_max_ns,__atomic_load_n(&s->hold_max_ns,__ATOMIC_RELAXED));
+		}
+		if (0 < sum.acquires) {
+			fprintf(stream,LOCK_STATS_LOCK_MSG,names[i],sum.acquires,sum.contended,100.0*sum.contended/sum.acquires,sum.wait_ns/1e6,sum.wait_max_ns/1e6,sum.hold_ns/1e6,sum.hold_max_ns/1e6);
+		}
+		if ((0 < sum.cond_waits)||(0 < sum.signals)||(0 < sum.broadcasts)) {
+			fprintf(stream,LOCK_STATS_COND_MSG,names[i],sum.cond_waits,sum.cond_wait_ns/1e6,sum.spurious,sum.signals,sum.broadcasts);
+		}
+	}
+}
+// lock_stats_destroy - free every record. Only when no other thread uses the wrappers anymore.
+static inline void lock_stats_destroy(void) {
+	lock_stats_record_t *rec;
+	while ((rec = lock_stats_records) != NULL) {
+		lock_stats_records = rec->next;
+		free(rec);
+	}
+	lock_stats_record = NULL;
+}
+
+#endif
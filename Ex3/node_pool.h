@@ -0,0 +1,215 @@
+#ifndef NODE_POOL_H
+#define NODE_POOL_H
+
+// Fixed size object pool for the intlist nodes, so push_head and pop_tail do not meet in malloc()'s arena locks.
+// Every thread allocates from and frees to its own cache without any locking. An empty cache takes a batch of
+// objects from the shared free list, and a cache that grew too big (readers free what writers allocated) gives
+// a batch back. Only these batch moves take the pool mutex. The shared list is refilled by carving new slabs,
+// mmap()ed 64KB at a time, or 2MB at a time with MADV_HUGEPAGE so the nodes sit on transparent huge pages.
+// Objects never go back to malloc(), node_pool_destroy() unmaps the slabs when the program ends.
+// There is one pool per program (the thread caches are '__thread' variables).
+
+#include <errno.h> // errno
+#include <pthread.h> // pthread_mutex_t, pthread_key_t, pthread_mutex_init, pthread_mutex_lock, pthread_mutex_unlock, pthread_mutex_destroy, pthread_key_create, pthread_key_delete, pthread_setspecific
+#include <stdio.h> // FILE, fprintf, stderr
+#include <stdlib.h> // EXIT_FAILURE, exit
+#include <string.h> // strerror
+#include <sys/mman.h> // PROT_READ, PROT_WRITE, MAP_PRIVATE, MAP_ANONYMOUS, MAP_FAILED, MADV_HUGEPAGE, mmap, madvise, munmap
+
+#define NODE_POOL_BATCH		64 // Objects moved between a thread cache and the shared list at once
+#define NODE_POOL_SLAB		(64*1024)
+#define NODE_POOL_SLAB_HUGE	(2*1024*1024) // One transparent huge page (x86-64)
+
+// Define printing strings
+#define NODE_POOL_STATS_MSG		"Pool: %ld slabs (%ld KB), high-water mark %ld nodes in use or cached, %ld refills, %ld spills\n"
+#define NODE_POOL_ERROR_GENERAL_MSG	"[Error] Error in %s: %s\n"
+
+typedef struct node_pool_free {
+	struct node_pool_free *next;
+} node_pool_free_t;
+typedef struct node_pool_cache {
+	node_pool_free_t *head;
+	long count;
+	int registered; // 1 once the exit destructor is set for this thread
+} node_pool_cache_t;
+typedef struct node_pool {
+	int enabled;
+	size_t obj_size; // Rounded up to a multiple of the pointer size
+	size_t slab_size;
+	int huge; // MADV_HUGEPAGE on every slab
+	pthread_mutex_t lock; // Protects everything below
+	node_pool_free_t *shared; // Free objects that no thread cache holds
+	long shared_count;
+	node_pool_free_t *slabs; // Every slab starts with its link, the objects follow
+	long slabs_count;
+	long in_use; // Objects out of the shared list (in use or in a thread cache), counted per batch
+	long in_use_hwm;
+	long refills;
+	long spills;
+} node_pool_t;
+
+static node_pool_t node_pool = {0};
+static __thread node_pool_cache_t node_pool_cache = {NULL,0,0};
+static pthread_key_t node_pool_key; // Its destructor gives the cache back when the thread exits
+
+static inline void node_pool_lock(void) {
+	int rc;
+	if ((rc = pthread_mutex_lock(&node_pool.lock)) != 0) { // If successful, the pthread_mutex_lock() function shall return zero; otherwise, an error number shall be returned to indicate the error.
+		fprintf(stderr,NODE_POOL_ERROR_GENERAL_MSG,"pthread_mutex_lock()",strerror(rc));
+		exit(EXIT_FAILURE);
+	}
+}
+static inline void node_pool_unlock(void) {
+	int rc;
+	if ((rc = pthread_mutex_unlock(&node_pool.lock)) != 0) { // If successful, the pthread_mutex_unlock() function shall return zero; otherwise, an error number shall be returned to indicate the error.
+		fprintf(stderr,NODE_POOL_ERROR_GENERAL_MSG,"pthread_mutex_unlock()",strerror(rc));
+		exit(EXIT_FAILURE);
+	}
+}
+// node_pool_spill - move 'count' objects from the thread cache to the shared list
+static inline void node_pool_spill(node_pool_cache_t *cache, long count) {
+	node_pool_free_t *first = cache->head;
+	node_pool_free_t *last = cache->head;
+	long i;
+	if (count <= 0) {
+		return;
+	}
+	for (i = 1; i < count; i++) { // Walk outside the lock
+		last = last->next;
+	}
+	cache->head = last->next;
+	cache->count -= count;
+	node_pool_lock();
+	last->next = node_pool.shared;
+	node_pool.shared = first;
+	node_pool.shared_count += count;
+	node_pool.in_use -= count;
+	node_pool.spills += 1;
+	node_pool_unlock();
+}
+static inline void node_pool_thread_exit(void *ptr) {
+	node_pool_cache_t *cache = ptr;
+	node_pool_spill(cache,cache->count);
+}
+static inline int node_pool_init(size_t obj_size, int huge) {
+	int rc;
+	node_pool.obj_size = ((obj_size+sizeof(void *)-1)/sizeof(void *))*sizeof(void *);
+	node_pool.slab_size = huge ? NODE_POOL_SLAB_HUGE : NODE_POOL_SLAB;
+	node_pool.huge = huge;
+	node_pool.shared = NULL;
+	node_pool.shared_count = 0;
+	node_pool.slabs = NULL;
+	node_pool.slabs_count = 0;
+	node_pool.in_use = 0;
+	node_pool.in_use_hwm = 0;
+	node_pool.refills = 0;
+	node_pool.spills = 0;
+	if ((rc = pthread_mutex_init(&node_pool.lock,NULL)) != 0) { // If successful, the pthread_mutex_init() function shall return zero; otherwise, an error number shall be returned to indicate the error.
+		return rc;
+	}
+	if ((rc = pthread_key_create(&node_pool_key,node_pool_thread_exit)) != 0) { // If successful, the pthread_key_create() function shall store the newly created key value at *key and shall return zero. Otherwise, an error number shall be returned to indicate the error.
+		pthread_mutex_destroy(&node_pool.lock);
+		return rc;
+	}
+	node_pool.enabled = 1;
+	return 0;
+}
+// node_pool_grow - carve a new slab into the shared list. Called with the pool mutex held.
+static inline void node_pool_grow(void) {
+	char *slab;
+	size_t offset;
+	node_pool_free_t *obj;
+	if ((slab = (char *)mmap(NULL,node_pool.slab_size,PROT_READ | PROT_WRITE,MAP_PRIVATE | MAP_ANONYMOUS,-1,0)) == MAP_FAILED) { // On success, mmap() returns a pointer to the mapped area. On error, the value MAP_FAILED ... is returned, and errno is set appropriately.
+		fprintf(stderr,NODE_POOL_ERROR_GENERAL_MSG,"mmap()",strerror(errno));
+		exit(EXIT_FAILURE);
+	}
+	if (node_pool.huge) {
+		madvise(slab,node_pool.slab_size,MADV_HUGEPAGE); // Only a hint, see /sys/kernel/mm/transparent_hugepage/enabled
+	}
+	((node_pool_free_t *)slab)->next = node_pool.slabs;
+	node_pool.slabs = (node_pool_free_t *)slab;
+	node_pool.slabs_count += 1;
+	for (offset = node_pool.obj_size; offset+node_pool.obj_size <= node_pool.slab_size; offset += node_pool.obj_size) { // The first object holds the slab link
+		obj = (node_pool_free_t *)(slab+offset);
+		obj->next = node_pool.shared;
+		node_pool.shared = obj;
+		node_pool.shared_count += 1;
+	}
+}
+// node_pool_refill - move a batch from the shared list to the thread cache, carving a new slab if needed
+static inline void node_pool_refill(node_pool_cache_t *cache) {
+	node_pool_free_t *obj;
+	long i;
+	if (!cache->registered) {
+		pthread_setspecific(node_pool_key,cache);
+		cache->registered = 1;
+	}
+	node_pool_lock();
+	if (node_pool.shared_count < NODE_POOL_BATCH) {
+		node_pool_grow();
+	}
+	for (i = 0; i < NODE_POOL_BATCH; i++) {
+		obj = node_pool.shared;
+		node_pool.shared = obj->next;
+		obj->next = cache->head;
+		cache->head = obj;
+	}
+	node_pool.shared_count -= NODE_POOL_BATCH;
+	node_pool.in_use += NODE_POOL_BATCH;
+	if (node_pool.in_use_hwm < node_pool.in_use) {
+		node_pool.in_use_hwm = node_pool.in_use;
+	}
+	node_pool.refills += 1;
+	node_pool_unlock();
+	cache->count += NODE_POOL_BATCH;
+}
+static inline void *node_pool_alloc(void) {
+	node_pool_cache_t *cache = &node_pool_cache;
+	node_pool_free_t *obj;
+	if (cache->head == NULL) {
+		node_pool_refill(cache);
+	}
+	obj = cache->head;
+	cache->head = obj->next;
+	cache->count -= 1;
+	return obj;
+}
+static inline void node_pool_free(void *ptr) {
+	node_pool_cache_t *cache = &node_pool_cache;
+	node_pool_free_t *obj = ptr;
+	obj->next = cache->head;
+	cache->head = obj;
+	cache->count += 1;
+	if (2*NODE_POOL_BATCH <= cache->count) { // Keep one batch, so a thread that both allocates and frees does not bounce
+		if (!cache->registered) {
+			pthread_setspecific(node_pool_key,cache);
+			cache->registered = 1;
+		}
+		node_pool_spill(cache,NODE_POOL_BATCH);
+	}
+}
+static inline void node_pool_print(FILE *stream) {
+	node_pool_lock();
+	fprintf(stream,NODE_POOL_STATS_MSG,node_pool.slabs_count,(long)(node_pool.slabs_count*node_pool.slab_size/1024),node_pool.in_use_hwm,node_pool.refills,node_pool.spills);
+	node_pool_unlock();
+}
+// node_pool_destroy - unmap every slab. Only when no thread uses the pool anymore.
+static inline void node_pool_destroy(void) {
+	node_pool_free_t *slab;
+	if (!node_pool.enabled) {
+		return;
+	}
+	while ((slab = node_pool.slabs) != NULL) {
+		node_pool.slabs = slab->next;
+		munmap(slab,node_pool.slab_size);
+	}
+	node_pool_cache.head = NULL; // The caller's cache pointed into the slabs
+	node_pool_cache.count = 0;
+	node_pool.shared = NULL;
+	node_pool.shared_count = 0;
+	node_pool.enabled = 0;
+	pthread_key_delete(node_pool_key);
+	pthread_mutex_destroy(&node_pool.lock);
+}
+
+#endif
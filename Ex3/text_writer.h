@@ -0,0 +1,124 @@
+#ifndef TEXT_WRITER_H
+#define TEXT_WRITER_H
+
+// Buffered decimal output for large dumps, one "%d\n" line per value without printf(). The digits are made
+// two at a time from a table, into chunks of TEXT_WRITER_CHUNK bytes. Once every chunk is full they go out
+// with a single writev(), so a million values cost a handful of system calls.
+// The writer bypasses stdio: fflush() the FILE on the same descriptor before the first value.
+
+#include <errno.h> // EINTR, errno
+#include <stdio.h> // fprintf, stderr
+#include <stdlib.h> // EXIT_FAILURE, exit, malloc, free
+#include <string.h> // memcpy, strerror
+#include <sys/uio.h> // struct iovec, writev
+
+#define TEXT_WRITER_CHUNK	(64*1024)
+#define TEXT_WRITER_CHUNKS	16 // Chunks per writev(), at most IOV_MAX
+#define TEXT_WRITER_LINE	12 // "-2147483648\n"
+
+// Define printing strings
+#define TEXT_WRITER_ERROR_MALLOC_MSG	"[Error] Failed to allocate memory to the output buffer.\n"
+#define TEXT_WRITER_ERROR_GENERAL_MSG	"[Error] Error in %s: %s\n"
+
+typedef struct text_writer {
+	int fd;
+	int chunk; // The chunk being filled
+	int used; // Bytes used in it
+	int lens[TEXT_WRITER_CHUNKS]; // Bytes in the full chunks
+	char *chunks; // TEXT_WRITER_CHUNKS chunks of TEXT_WRITER_CHUNK bytes
+} text_writer_t;
+
+static const char text_writer_digits[201] =
+	"00010203040506070809" "10111213141516171819" "20212223242526272829" "30313233343536373839" "40414243444546474849"
+	"50515253545556575859" "60616263646566676869" "70717273747576777879" "80818283848586878889" "90919293949596979899";
+
+static inline void text_writer_init(text_writer_t *w, int fd) {
+	w->fd = fd;
+	w->chunk = 0;
+	w->used = 0;
+	if ((w->chunks = (char *)malloc(TEXT_WRITER_CHUNKS*TEXT_WRITER_CHUNK)) == NULL) { // The malloc() function return a pointer to the allocated memory that is suitably aligned for any kind of variable. On error, these functions return NULL.
+		fprintf(stderr,TEXT_WRITER_ERROR_MALLOC_MSG);
+		exit(EXIT_FAILURE);
+	}
+}
+// text_writer_flush - write the full chunks and the used part of the current one, retrying short writes
+static inline void text_writer_flush(text_writer_t *w) {
+	struct iovec iov[TEXT_WRITER_CHUNKS];
+	struct iovec *next = iov;
+	int count = 0;
+	int i;
+	ssize_t written;
+	w->lens[w->chunk] = w->used;
+	for (i = 0; i <= w->chunk; i++) {
+		if (0 < w->lens[i]) {
+			iov[count].iov_base = w->chunks+(size_t)i*TEXT_WRITER_CHUNK;
+			iov[count].iov_len = w->lens[i];
+			count += 1;
+		}
+	}
+	while (0 < count) {
+		if ((written = writev(w->fd,next,count)) < 0) { // On success, readv(), preadv(), writev(), and pwritev() return the number of bytes read or written. On error, -1 is returned, and errno is set appropriately.
+			if (errno == EINTR) {
+				continue;
+			}
+			fprintf(stderr,TEXT_WRITER_ERROR_GENERAL_MSG,"writev()",strerror(errno));
+			exit(EXIT_FAILURE);
+		}
+		while ((0 < count)&&((size_t)written >= next->iov_len)) { // A pipe or a full disk may take less
+			written -= next->iov_len;
+			next += 1;
+			count -= 1;
+		}
+		if (0 < count) {
+			next->iov_base = (char *)next->iov_base+written;
+			next->iov_len -= written;
+		}
+	}
+	w->chunk = 0;
+	w->used = 0;
+}
+// text_writer_int - append 'value' and a newline
+static inline void text_writer_int(text_writer_t *w, int value) {
+	char tmp[TEXT_WRITER_LINE];
+	char *end = tmp+TEXT_WRITER_LINE;
+	char *p = end;
+	char *out;
+	unsigned int u = (value < 0) ? 0u-(unsigned int)value : (unsigned int)value; // INT_MIN has no positive int
+	*--p = '\n';
+	while (100 <= u) {
+		p -= 2;
+		p[0] = text_writer_digits[2*(u % 100)];
+		p[1] = text_writer_digits[2*(u % 100)+1];
+		u /= 100;
+	}
+	if (10 <= u) {
+		p -= 2;
+		p[0] = text_writer_digits[2*u];
+		p[1] = text_writer_digits[2*u+1];
+	} else {
+		*--p = (char)('0'+u);
+	}
+	if (value < 0) {
+		*--p = '-';
+	}
+	if (TEXT_WRITER_CHUNK-w->used < end-p) { // Next chunk, or out with all of them
+		w->lens[w->chunk] = w->used;
+		if (w->chunk+1 == TEXT_WRITER_CHUNKS) {
+			text_writer_flush(w);
+		} else {
+			w->chunk += 1;
+			w->used = 0;
+		}
+	}
+	out = w->chunks+(size_t)w->chunk*TEXT_WRITER_CHUNK+w->used;
+	memcpy(out,p,end-p);
+	w->used += end-p;
+}
+// text_writer_destroy - flush what is left and free the chunks
+static inline void text_writer_destroy(text_writer_t *w) {
+	text_writer_flush(w);
+	free(w->chunks);
+	w->chunks = NULL;
+}
+
+#endif